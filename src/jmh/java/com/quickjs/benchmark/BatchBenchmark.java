@@ -0,0 +1,67 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Applying one function to many rows: a per-row call loop against a single
+ * mapBatch. Scores are rows per second.
+ */
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class BatchBenchmark {
+    private static final int ROWS = 10_000;
+
+    private JSRuntime runtime;
+    private JSContext context;
+    private JSValue func;
+    private final double[] prices = new double[ROWS];
+    private final int[] quantities = new int[ROWS];
+    private final double[] totals = new double[ROWS];
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        func = context.eval("(function(price, qty) { return price * qty; })");
+        for (int i = 0; i < ROWS; i++) {
+            prices[i] = i * 0.25;
+            quantities[i] = i % 7;
+        }
+    }
+
+    @TearDown
+    public void tearDown() {
+        func.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    @OperationsPerInvocation(ROWS)
+    public double[] perRowCall() {
+        for (int i = 0; i < ROWS; i++) {
+            try (JSValue price = context.createDouble(prices[i]);
+                    JSValue qty = context.createInteger(quantities[i]);
+                    JSValue result = func.call(null, price, qty)) {
+                totals[i] = result.asDouble();
+            }
+        }
+        return totals;
+    }
+
+    @Benchmark
+    @OperationsPerInvocation(ROWS)
+    public double[] mapBatch() {
+        return context.mapBatch(func, new Object[] { prices, quantities }, ROWS, totals);
+    }
+}
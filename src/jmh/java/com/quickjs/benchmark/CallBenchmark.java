@@ -0,0 +1,53 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class CallBenchmark {
+    @Param({ "0", "1", "2", "4", "8" })
+    public int argCount;
+
+    private JSRuntime runtime;
+    private JSContext context;
+    private JSValue func;
+    private JSValue[] args;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        func = context.eval("(function() { return arguments.length; })");
+        args = new JSValue[argCount];
+        for (int i = 0; i < argCount; i++) {
+            args[i] = context.createInteger(i);
+        }
+    }
+
+    @TearDown
+    public void tearDown() {
+        for (JSValue arg : args) {
+            arg.close();
+        }
+        func.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public int call() {
+        try (JSValue result = func.call(null, args)) {
+            return result.asInteger();
+        }
+    }
+}
@@ -0,0 +1,55 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JS -> Java -> JS round trips through callback_trampoline. Each invocation
+ * runs a JS loop of {@link #CALLS} host calls so eval overhead is amortized.
+ */
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class CallbackBenchmark {
+    private static final int CALLS = 1000;
+
+    private JSRuntime runtime;
+    private JSContext context;
+    private JSValue loop;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        // The trampoline takes its own reference to the result, so returning
+        // the argument itself leaves no extra handle for the Cleaner
+        try (JSValue host = context.createFunction((ctx, thisObj, args) -> args[0], "host", 1)) {
+            context.setGlobal("host", host);
+        }
+        loop = context.eval("(function(n) { var s = 0; for (var i = 0; i < n; i++) s += host(i); return s; })");
+    }
+
+    @TearDown
+    public void tearDown() {
+        loop.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    @OperationsPerInvocation(CALLS)
+    public int roundTrip() {
+        try (JSValue n = context.createInteger(CALLS);
+                JSValue result = loop.call(null, n)) {
+            return result.asInteger();
+        }
+    }
+}
@@ -0,0 +1,110 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class ConversionBenchmark {
+    @Param({ "10", "1000" })
+    public int size;
+
+    private JSRuntime runtime;
+    private JSContext context;
+    private Map<String, Object> nested;
+    private JSValue jsList;
+    private JSValue jsNested;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+
+        nested = new HashMap<>();
+        List<Object> rows = new ArrayList<>();
+        for (int i = 0; i < size; i++) {
+            Map<String, Object> row = new HashMap<>();
+            row.put("id", i);
+            row.put("name", "row" + i);
+            row.put("score", i * 0.5);
+            row.put("tags", List.of("a", "b"));
+            rows.add(row);
+        }
+        nested.put("rows", rows);
+        nested.put("count", size);
+
+        jsList = context.eval("Array.from({ length: " + size + " }, (_, i) => 'item' + i)");
+        // The JS counterpart of nested
+        jsNested = context.eval("({ rows: Array.from({ length: " + size + " }, (_, i) =>"
+                + " ({ id: i, name: 'row' + i, score: i * 0.5, tags: ['a', 'b'] })), count: " + size + " })");
+    }
+
+    @TearDown
+    public void tearDown() {
+        jsList.close();
+        jsNested.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public void toJSValue() {
+        context.toJSValue(nested).close();
+    }
+
+    @Benchmark
+    public List<?> toJavaObject() {
+        return jsList.toJavaObject(List.class);
+    }
+
+    @Benchmark
+    public Object toJavaNested() {
+        return toJava(jsNested);
+    }
+
+    // Objects and arrays of any depth, read through entries() and iteration
+    private static Object toJava(JSValue value) {
+        if (value.isArray()) {
+            List<Object> list = new ArrayList<>();
+            for (JSValue item : value) {
+                try (item) {
+                    list.add(toJava(item));
+                }
+            }
+            return list;
+        }
+        if (value.isObject()) {
+            Map<String, JSValue> entries = value.entries();
+            Map<String, Object> map = new HashMap<>(entries.size() * 2);
+            for (Map.Entry<String, JSValue> entry : entries.entrySet()) {
+                try (JSValue item = entry.getValue()) {
+                    map.put(entry.getKey(), toJava(item));
+                }
+            }
+            return map;
+        }
+        if (value.isInteger()) {
+            return value.asInteger();
+        }
+        if (value.isNumber()) {
+            return value.asDouble();
+        }
+        if (value.isBoolean()) {
+            return value.asBoolean();
+        }
+        return value.isNull() || value.isUndefined() ? null : value.asString();
+    }
+}
@@ -0,0 +1,55 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class EvalBenchmark {
+    private JSRuntime runtime;
+    private JSContext context;
+    private String largeScript;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+
+        // ~100 KB of functions, exercising the parser more than the interpreter
+        StringBuilder sb = new StringBuilder();
+        for (int i = 0; i < 1000; i++) {
+            sb.append("function f").append(i).append("(a, b) { var s = 0; for (var i = 0; i < a; i++) { s += b * i; } return s; }\n");
+        }
+        sb.append("f999(10, 2);");
+        largeScript = sb.toString();
+    }
+
+    @TearDown
+    public void tearDown() {
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public int evalSmall() {
+        try (JSValue result = context.eval("1 + 2")) {
+            return result.asInteger();
+        }
+    }
+
+    @Benchmark
+    public int evalLarge() {
+        try (JSValue result = context.eval(largeScript)) {
+            return result.asInteger();
+        }
+    }
+}
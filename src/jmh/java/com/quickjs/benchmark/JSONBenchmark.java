@@ -0,0 +1,50 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class JSONBenchmark {
+    @Param({ "10", "1000", "100000" })
+    public int size;
+
+    private JSRuntime runtime;
+    private JSContext context;
+    private String json;
+    private JSValue value;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        value = context.eval("Array.from({ length: " + size + " }, (_, i) => ({ id: i, name: 'row' + i, ok: i % 2 === 0 }))");
+        json = value.toJSON();
+    }
+
+    @TearDown
+    public void tearDown() {
+        value.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public void parseJSON() {
+        context.parseJSON(json).close();
+    }
+
+    @Benchmark
+    public String toJSON() {
+        return value.toJSON();
+    }
+}
@@ -0,0 +1,57 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSIntrinsic;
+import com.quickjs.JSRuntime;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.EnumSet;
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class LifecycleBenchmark {
+    private JSRuntime runtime;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+    }
+
+    @TearDown
+    public void tearDown() {
+        runtime.close();
+    }
+
+    @Benchmark
+    public void createRuntime() {
+        QuickJS.createRuntime().close();
+    }
+
+    @Benchmark
+    public void createContext() {
+        try (JSContext context = runtime.createContext()) {
+            // creation and teardown only
+        }
+    }
+
+    @Benchmark
+    public void createMinimalContext() {
+        try (JSContext context = runtime.createContext(EnumSet.of(JSIntrinsic.JSON))) {
+            // base objects and JSON only, compare against createContext
+        }
+    }
+
+    @Benchmark
+    public void createContextWithoutStdLib() {
+        try (JSRuntime raw = QuickJS.builder().withoutStdLib().build();
+                JSContext context = raw.createContext()) {
+            // includes runtime creation, compare against createRuntime
+        }
+    }
+}
@@ -0,0 +1,55 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class PromiseBenchmark {
+    private JSRuntime runtime;
+    private JSContext context;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+    }
+
+    @TearDown
+    public void tearDown() {
+        context.close();
+        runtime.close();
+    }
+
+    /** Java future -> JS promise, resolved and drained through the event loop. */
+    @Benchmark
+    public void javaToJS() {
+        CompletableFuture<Object> future = new CompletableFuture<>();
+        try (JSValue promise = context.createPromise(future)) {
+            future.complete(1);
+            runtime.runEventLoop();
+        }
+    }
+
+    /** JS promise -> Java future. */
+    @Benchmark
+    public int jsToJava() throws Exception {
+        try (JSValue promise = context.eval("Promise.resolve(1)")) {
+            CompletableFuture<JSValue> future = promise.toFuture();
+            runtime.runEventLoop();
+            try (JSValue result = future.get()) {
+                return result.asInteger();
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class PropertyBenchmark {
+    private JSRuntime runtime;
+    private JSContext context;
+    private JSValue object;
+    private JSValue array;
+    private JSValue value;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        object = context.eval("({ name: 'Alice', age: 30 })");
+        array = context.eval("[1, 2, 3, 4, 5, 6, 7, 8]");
+        value = context.createInteger(42);
+    }
+
+    @TearDown
+    public void tearDown() {
+        value.close();
+        array.close();
+        object.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public int getByName() {
+        try (JSValue age = object.getProperty("age")) {
+            return age.asInteger();
+        }
+    }
+
+    @Benchmark
+    public void setByName() {
+        object.setProperty("age", value);
+    }
+
+    @Benchmark
+    public int getByIndex() {
+        try (JSValue item = array.getProperty(3)) {
+            return item.asInteger();
+        }
+    }
+
+    @Benchmark
+    public void setByIndex() {
+        array.setProperty(3, value);
+    }
+}
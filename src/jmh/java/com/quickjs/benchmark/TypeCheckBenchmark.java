@@ -0,0 +1,70 @@
+package com.quickjs.benchmark;
+
+import com.quickjs.JSContext;
+import com.quickjs.JSRuntime;
+import com.quickjs.JSValue;
+import com.quickjs.QuickJS;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+
+// Type checks and primitive reads, the natives that FFM downcalls replace on
+// JDK 22+. Compare a run on JDK 11 with one on JDK 22 against the jar.
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class TypeCheckBenchmark {
+    private JSRuntime runtime;
+    private JSContext context;
+    private JSValue integer;
+    private JSValue number;
+    private JSValue function;
+
+    @Setup
+    public void setup() {
+        runtime = QuickJS.createRuntime();
+        context = runtime.createContext();
+        integer = context.eval("42");
+        number = context.eval("4.2");
+        function = context.eval("(function() {})");
+    }
+
+    @TearDown
+    public void tearDown() {
+        function.close();
+        number.close();
+        integer.close();
+        context.close();
+        runtime.close();
+    }
+
+    @Benchmark
+    public boolean isString() {
+        return integer.isString();
+    }
+
+    @Benchmark
+    public boolean isFunction() {
+        return function.isFunction();
+    }
+
+    @Benchmark
+    public int asInteger() {
+        return integer.asInteger();
+    }
+
+    @Benchmark
+    public double asDouble() {
+        return number.asDouble();
+    }
+
+    @Benchmark
+    public int createAndClose() {
+        try (JSValue value = context.createInteger(7)) {
+            return value.getTypeTag();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+package com.quickjs;
+
+/**
+ * Describes how a {@link JSExport} class appears in JS. Subclasses are
+ * generated by {@link com.quickjs.processor.JSExportProcessor} and named after
+ * the exported class's binary name with {@code $} replaced by {@code _} and
+ * {@value #SUFFIX} appended; they are not meant to be written by hand.
+ * <p>
+ * Members are listed by JNI descriptor so the native side can resolve them to
+ * method IDs once per runtime and call them without reflection.
+ */
+public abstract class JSClassBinding {
+    static final String SUFFIX = "_JSBinding";
+
+    private static final ClassValue<JSClassBinding> BINDINGS = new ClassValue<JSClassBinding>() {
+        @Override
+        protected JSClassBinding computeValue(Class<?> type) {
+            String name = type.getName().replace('$', '_') + SUFFIX;
+            try {
+                return (JSClassBinding) Class.forName(name, true, type.getClassLoader())
+                        .getDeclaredConstructor().newInstance();
+            } catch (ClassNotFoundException e) {
+                return null;
+            } catch (ReflectiveOperationException e) {
+                throw new IllegalStateException("Cannot instantiate " + name, e);
+            }
+        }
+    };
+
+    final Class<?> type;
+    final String className;
+    final String[] jsNames;
+    final String[] javaNames;
+    final String[] signatures;
+    final boolean[] getters;
+
+    protected JSClassBinding(Class<?> type, String className, String[] jsNames, String[] javaNames,
+            String[] signatures, boolean[] getters) {
+        this.type = type;
+        this.className = className;
+        this.jsNames = jsNames;
+        this.javaNames = javaNames;
+        this.signatures = signatures;
+        this.getters = getters;
+    }
+
+    /**
+     * Find the generated binding for {@code type} or its closest exported
+     * superclass.
+     */
+    static JSClassBinding forClass(Class<?> type) {
+        for (Class<?> c = type; c != null; c = c.getSuperclass()) {
+            JSClassBinding binding = BINDINGS.get(c);
+            if (binding != null) {
+                return binding;
+            }
+        }
+        throw new IllegalArgumentException(type + " is not annotated with @JSExport");
+    }
+}
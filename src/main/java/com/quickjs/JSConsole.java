@@ -0,0 +1,245 @@
+package com.quickjs;
+
+import java.lang.ref.Cleaner;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.locks.LockSupport;
+import java.util.function.LongConsumer;
+
+/**
+ * A native {@code console} for scripts that never blocks them on logging.
+ *
+ * <p>
+ * Install it with {@link JSContext#setConsole(JSConsole)}. {@code console.log},
+ * {@code info}, {@code debug}, {@code trace}, {@code warn} and {@code error}
+ * then format their arguments natively (strings as is, plain objects and
+ * arrays as JSON, anything else through {@code String()}, joined by spaces)
+ * and queue the line in a bounded lock-free ring buffer. A daemon thread
+ * drains the buffer and passes the lines to the {@link JSConsoleSink} in
+ * batches. When scripts log faster than the sink consumes, lines are dropped
+ * according to the {@link OverflowPolicy} and counted by
+ * {@link #getDroppedCount()}.
+ *
+ * <p>
+ * One console may be installed in any number of contexts, on any runtimes
+ * and threads.
+ */
+public final class JSConsole implements AutoCloseable {
+
+    // Order is shared with the native CONSOLE_* levels
+    public enum Level {
+        DEBUG(System.Logger.Level.DEBUG),
+        INFO(System.Logger.Level.INFO),
+        WARN(System.Logger.Level.WARNING),
+        ERROR(System.Logger.Level.ERROR);
+
+        final System.Logger.Level platformLevel;
+
+        Level(System.Logger.Level platformLevel) {
+            this.platformLevel = platformLevel;
+        }
+    }
+
+    /** What to drop when the buffer is full. */
+    public enum OverflowPolicy {
+        /** Keep the buffered lines and drop the one being logged. */
+        DROP_NEWEST,
+        /** Drop the oldest buffered line to make room. */
+        DROP_OLDEST
+    }
+
+    public static final int DEFAULT_CAPACITY = 8192;
+
+    private static final Level[] LEVELS = Level.values();
+    private static final int BATCH_SIZE = 256;
+    private static final long MIN_IDLE_NANOS = TimeUnit.MICROSECONDS.toNanos(500);
+    private static final long MAX_IDLE_NANOS = TimeUnit.MILLISECONDS.toNanos(20);
+
+    private final Drainer drainer;
+    private final Cleaner.Cleanable cleanable;
+
+    private JSConsole(JSConsoleSink sink, int capacity, OverflowPolicy policy) {
+        this.drainer = new Drainer(sink, createRingInternal(capacity, policy == OverflowPolicy.DROP_OLDEST));
+        // The drain thread only holds the Drainer, so an abandoned console is
+        // still collected and its thread stopped
+        this.cleanable = QuickJS.cleaner.register(this, drainer::stop);
+        drainer.thread.start();
+    }
+
+    public static JSConsole create(JSConsoleSink sink) {
+        return create(sink, DEFAULT_CAPACITY, OverflowPolicy.DROP_NEWEST);
+    }
+
+    /**
+     * @param capacity lines the buffer holds, rounded up to a power of two.
+     */
+    public static JSConsole create(JSConsoleSink sink, int capacity, OverflowPolicy policy) {
+        if (capacity <= 0) {
+            throw new IllegalArgumentException("capacity must be positive");
+        }
+        return new JSConsole(sink, capacity, policy);
+    }
+
+    /** Lines passed to the sink so far. */
+    public long getDeliveredCount() {
+        return drainer.delivered.get();
+    }
+
+    /** Lines lost to a full buffer. Lines logged after {@link #close()} are not counted. */
+    public long getDroppedCount() {
+        return drainer.droppedCount();
+    }
+
+    /** Batches for which the sink threw. */
+    public long getSinkFailureCount() {
+        return drainer.sinkFailures.get();
+    }
+
+    /** Pass every line buffered so far to the sink on the calling thread. */
+    public void flush() {
+        drainer.flush();
+    }
+
+    /**
+     * Stop the drain thread and flush the remaining lines. Contexts that still
+     * have this console installed discard what they log from then on. A
+     * console that is never closed is stopped once it becomes unreachable,
+     * without waiting for its last lines to be delivered.
+     */
+    @Override
+    public void close() {
+        cleanable.clean();
+        drainer.awaitStopped();
+    }
+
+    /** Run {@code install} with the ring, which is not released before it returns. */
+    void install(LongConsumer install) {
+        drainer.install(install);
+    }
+
+    private static final class Drainer implements Runnable {
+        private final JSConsoleSink sink;
+        private final Thread thread;
+        private final AtomicLong delivered = new AtomicLong();
+        private final AtomicLong sinkFailures = new AtomicLong();
+        // Serializes drains, so batches reach the sink in order, and guards
+        // the batch arrays. Taken before the monitor, which only guards
+        // ringPtr and is never held while the sink runs.
+        private final Object drainLock = new Object();
+        private final int[] levels = new int[BATCH_SIZE];
+        private final long[] timestamps = new long[BATCH_SIZE];
+        private final String[] sources = new String[BATCH_SIZE];
+        private final String[] messages = new String[BATCH_SIZE];
+        private long ringPtr;
+        private long droppedAtClose;
+        private volatile boolean closed = false;
+
+        Drainer(JSConsoleSink sink, long ringPtr) {
+            this.sink = sink;
+            this.ringPtr = ringPtr;
+            this.thread = new Thread(this, "quickjs-console");
+            this.thread.setDaemon(true);
+        }
+
+        synchronized long droppedCount() {
+            return ringPtr != 0 ? droppedInternal(ringPtr) : droppedAtClose;
+        }
+
+        synchronized void install(LongConsumer install) {
+            if (ringPtr == 0) {
+                throw new IllegalStateException("JSConsole is closed");
+            }
+            install.accept(ringPtr);
+        }
+
+        // Cleaner action: the drain thread flushes and releases the ring on its way out
+        void stop() {
+            closed = true;
+            LockSupport.unpark(thread);
+        }
+
+        void awaitStopped() {
+            if (Thread.currentThread() == thread) {
+                // Closed by the sink; the thread stops once the sink returns
+                return;
+            }
+            boolean interrupted = false;
+            while (thread.isAlive()) {
+                try {
+                    thread.join();
+                } catch (InterruptedException e) {
+                    interrupted = true;
+                }
+            }
+            if (interrupted) {
+                Thread.currentThread().interrupt();
+            }
+        }
+
+        @Override
+        public void run() {
+            long idleNanos = MIN_IDLE_NANOS;
+            while (!closed) {
+                if (drain() > 0) {
+                    idleNanos = MIN_IDLE_NANOS;
+                } else {
+                    // Producers never wake us, so back off while idle
+                    LockSupport.parkNanos(this, idleNanos);
+                    idleNanos = Math.min(idleNanos * 2, MAX_IDLE_NANOS);
+                }
+            }
+            flush();
+            synchronized (drainLock) {
+                synchronized (this) {
+                    droppedAtClose = droppedInternal(ringPtr);
+                    releaseRingInternal(ringPtr);
+                    ringPtr = 0;
+                }
+            }
+        }
+
+        void flush() {
+            while (drain() == BATCH_SIZE) {
+                // More may be waiting
+            }
+        }
+
+        // Deliver one batch, returning its size
+        private int drain() {
+            synchronized (drainLock) {
+                // Only released with drainLock held, so stable here
+                if (ringPtr == 0) {
+                    return 0;
+                }
+                int count = drainInternal(ringPtr, levels, timestamps, sources, messages);
+                if (count == 0) {
+                    return 0;
+                }
+                List<JSConsoleRecord> batch = new ArrayList<>(count);
+                for (int i = 0; i < count; i++) {
+                    batch.add(new JSConsoleRecord(LEVELS[levels[i]], timestamps[i], sources[i], messages[i]));
+                    sources[i] = null;
+                    messages[i] = null;
+                }
+                try {
+                    sink.write(batch);
+                } catch (RuntimeException e) {
+                    sinkFailures.incrementAndGet();
+                }
+                delivered.addAndGet(count);
+                return count;
+            }
+        }
+    }
+
+    private static native long createRingInternal(int capacity, boolean dropOldest);
+
+    private static native void releaseRingInternal(long ringPtr);
+
+    private static native long droppedInternal(long ringPtr);
+
+    private static native int drainInternal(long ringPtr, int[] levels, long[] timestamps, String[] sources,
+            String[] messages);
+}
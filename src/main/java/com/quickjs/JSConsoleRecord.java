@@ -0,0 +1,42 @@
+package com.quickjs;
+
+/** One line written by a script through {@code console}. */
+public final class JSConsoleRecord {
+    private final JSConsole.Level level;
+    private final long timestampMillis;
+    private final String source;
+    private final String message;
+
+    JSConsoleRecord(JSConsole.Level level, long timestampMillis, String source, String message) {
+        this.level = level;
+        this.timestampMillis = timestampMillis;
+        this.source = source;
+        this.message = message;
+    }
+
+    public JSConsole.Level getLevel() {
+        return level;
+    }
+
+    /** When the script logged the line, in milliseconds since the epoch. */
+    public long getTimestampMillis() {
+        return timestampMillis;
+    }
+
+    /**
+     * @return the source passed to {@link JSContext#setConsole(JSConsole, String)},
+     *         or null.
+     */
+    public String getSource() {
+        return source;
+    }
+
+    public String getMessage() {
+        return message;
+    }
+
+    @Override
+    public String toString() {
+        return (source != null ? "[" + source + "] " : "") + level + " " + message;
+    }
+}
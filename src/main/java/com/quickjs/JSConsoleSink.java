@@ -0,0 +1,28 @@
+package com.quickjs;
+
+import java.util.List;
+
+/**
+ * Receives the lines scripts log through a {@link JSConsole}, in batches, on
+ * the console's drain thread.
+ */
+@FunctionalInterface
+public interface JSConsoleSink {
+    void write(List<JSConsoleRecord> records);
+
+    /**
+     * A sink writing to a platform logger, which SLF4J, Log4j and other logging
+     * frameworks can back. The record's source, if any, prefixes the message.
+     */
+    static JSConsoleSink forLogger(System.Logger logger) {
+        return records -> {
+            for (JSConsoleRecord record : records) {
+                System.Logger.Level level = record.getLevel().platformLevel;
+                if (logger.isLoggable(level)) {
+                    String source = record.getSource();
+                    logger.log(level, source != null ? "[" + source + "] " + record.getMessage() : record.getMessage());
+                }
+            }
+        };
+    }
+}
@@ -11,7 +11,7 @@ public class JSContext implements AutoCloseable {
     JSContext(long ptr, JSRuntime runtime) {
         this.ptr = ptr;
         this.runtime = runtime;
-        this.cleanable = QuickJS.cleaner.register(this, new NativeContextCleaner(ptr));
+        this.cleanable = QuickJS.cleaner.register(this, runtime.releaseQueue().context(ptr));
         registerJavaContext(ptr, this);
     }
 
@@ -23,10 +23,36 @@ public class JSContext implements AutoCloseable {
     }
 
     public JSValue eval(String script, String fileName, int type) {
+        return eval(script, fileName, type, JSExecutionLimit.NO_LIMIT, JSExecutionLimit.NO_LIMIT);
+    }
+
+    public JSValue eval(String script, JSExecutionLimit limit) {
+        return eval(script, "<input>", EVAL_TYPE_GLOBAL, limit);
+    }
+
+    /**
+     * Evaluate a script that is aborted with {@link JSTimeoutException} once it
+     * exceeds {@code limit}.
+     */
+    public JSValue eval(String script, String fileName, int type, JSExecutionLimit limit) {
+        return eval(script, fileName, type, limit.remainingMicros(), limit.interruptChecks());
+    }
+
+    private JSValue eval(String script, String fileName, int type, long timeoutMicros, long interruptBudget) {
         runtime.checkThread();
         checkClosed();
-        long valPtr = evalInternal(ptr, script, fileName, type);
-        return new JSValue(valPtr, this);
+        runtime.releaseQueue().drain();
+        JSMetrics metrics = runtime.getMetrics();
+        long start = metrics != null ? System.nanoTime() : 0;
+        try {
+            long valPtr = evalInternal(ptr, script, fileName, type, timeoutMicros, interruptBudget);
+            return new JSValue(valPtr, this);
+        } finally {
+            if (metrics != null) {
+                metrics.record(JSOperation.EVAL, fileName, null, System.nanoTime() - start);
+            }
+            runtime.afterInvocation();
+        }
     }
 
     public JSValue eval(java.nio.file.Path path) throws java.io.IOException {
@@ -43,6 +69,46 @@ public class JSContext implements AutoCloseable {
         return new JSValue(valPtr, this);
     }
 
+    /** Recreate a value from the output of {@link JSValue#serialize()}. */
+    public JSValue deserialize(byte[] data) {
+        return deserialize(data, 0, data.length);
+    }
+
+    public JSValue deserialize(byte[] data, int offset, int length) {
+        runtime.checkThread();
+        checkClosed();
+        java.util.Objects.checkFromIndexSize(offset, length, data.length);
+        long valPtr = deserializeInternal(ptr, data, offset, length);
+        return new JSValue(valPtr, this);
+    }
+
+    /**
+     * Recreate a value from the remaining bytes of {@code buffer}, leaving its
+     * position unchanged. A direct buffer is read in place without copying.
+     */
+    public JSValue deserialize(java.nio.ByteBuffer buffer) {
+        if (buffer.hasArray()) {
+            return deserialize(buffer.array(), buffer.arrayOffset() + buffer.position(), buffer.remaining());
+        }
+        if (!buffer.isDirect()) {
+            byte[] data = new byte[buffer.remaining()];
+            buffer.duplicate().get(data);
+            return deserialize(data);
+        }
+        runtime.checkThread();
+        checkClosed();
+        long valPtr = deserializeDirectInternal(ptr, buffer, buffer.position(), buffer.remaining());
+        return new JSValue(valPtr, this);
+    }
+
+    // Read a message from JSValue.writeMessage; the caller still owns the message
+    JSValue readMessage(long message) {
+        runtime.checkThread();
+        checkClosed();
+        long valPtr = readMessageInternal(ptr, message);
+        return new JSValue(valPtr, this);
+    }
+
     public JSValue createFunction(JSFunction callback, String name, int argCount) {
         runtime.checkThread();
         checkClosed();
@@ -99,15 +165,83 @@ public class JSContext implements AutoCloseable {
         return new JSValue(valPtr, this);
     }
 
+    // Export classes whose prototype is already installed in this context
+    private final java.util.Set<Long> installedExportClasses = new java.util.HashSet<>();
+
+    /**
+     * Wrap a {@link JSExport} object in an instance of its generated JS class.
+     * Method calls and getters on the result call straight into the Java
+     * object; the object stays reachable until the JS wrapper is collected.
+     */
+    public JSValue exportObject(Object target) {
+        runtime.checkThread();
+        checkClosed();
+        long classHandle = runtime.getExportClass(JSClassBinding.forClass(target.getClass()));
+        if (installedExportClasses.add(classHandle)) {
+            installExportClassInternal(ptr, classHandle);
+        }
+        long valPtr = newExportObjectInternal(ptr, classHandle, target);
+        return new JSValue(valPtr, this);
+    }
+
+    /**
+     * Expose a Java map to JS without copying it. Property reads, writes,
+     * {@code in}, {@code delete} and enumeration go straight to the map on
+     * access; nested maps and lists are exposed as views too. A read-only view
+     * throws a TypeError on any modification. The view has a null prototype,
+     * so every property name is a map key.
+     */
+    public JSValue createMapView(java.util.Map<String, ?> map, boolean writable) {
+        runtime.checkThread();
+        checkClosed();
+        long valPtr = createViewInternal(ptr, java.util.Objects.requireNonNull(map), writable);
+        return new JSValue(valPtr, this);
+    }
+
+    /**
+     * Expose a Java list to JS without copying it. Indices and {@code length}
+     * read through to the list, and the view inherits {@code Array.prototype}
+     * so iteration and array methods work. A writable view supports
+     * assignment to existing indices and appending, but not resizing.
+     */
+    public JSValue createListView(java.util.List<?> list, boolean writable) {
+        runtime.checkThread();
+        checkClosed();
+        long valPtr = createViewInternal(ptr, java.util.Objects.requireNonNull(list), writable);
+        return new JSValue(valPtr, this);
+    }
+
     public void setGlobal(String key, JSValue value) {
         try (JSValue global = getGlobalObject()) {
             global.setProperty(key, value);
         }
     }
 
+    /** Define {@code console} in this context, writing to {@code console}. */
+    public void setConsole(JSConsole console) {
+        setConsole(console, null);
+    }
+
+    /**
+     * Define {@code console} in this context, writing to {@code console} with
+     * every line tagged with {@code source} (e.g. a tenant or script name).
+     */
+    public void setConsole(JSConsole console, String source) {
+        runtime.checkThread();
+        checkClosed();
+        // The console cannot release its ring until the binding holds it
+        console.install(ring -> installConsoleInternal(ptr, ring, source));
+    }
+
     @Override
     public void close() {
         runtime.checkThread();
+        // Format exceptions still holding a JS error before it is freed
+        for (QuickJSException exception : lazyExceptions) {
+            exception.materialize();
+        }
+        lazyExceptions.clear();
+        runtime.releaseQueue().drain();
         cleanable.clean();
         ptr = 0;
     }
@@ -116,23 +250,139 @@ public class JSContext implements AutoCloseable {
         runtime.checkThread();
     }
 
+    boolean isOwnerThread() {
+        return runtime.isOwnerThread();
+    }
+
+    JSRuntime getRuntime() {
+        return runtime;
+    }
+
+    JSMetrics getMetrics() {
+        return runtime.getMetrics();
+    }
+
+    void afterInvocation() {
+        runtime.afterInvocation();
+    }
+
+    JSReleaseQueue releaseQueue() {
+        return runtime.releaseQueue();
+    }
+
+    // Exceptions thrown from this context whose message is not yet formatted
+    private final java.util.Set<QuickJSException> lazyExceptions = java.util.Collections
+            .newSetFromMap(new java.util.WeakHashMap<>());
+
+    void trackException(QuickJSException exception) {
+        lazyExceptions.add(exception);
+    }
+
     private void checkClosed() {
         if (ptr == 0) {
             throw new IllegalStateException("JSContext is closed");
         }
     }
 
-    private static class NativeContextCleaner implements Runnable {
-        private final long ptr;
+    /**
+     * Call {@code fn} once per row with one argument taken from each input
+     * column, storing each result in {@code output}. The loop runs natively,
+     * so a row costs only its JS execution. Columns may be {@code int[]},
+     * {@code long[]}, {@code double[]}, {@code boolean[]}, {@code String[]},
+     * or direct {@link java.nio.IntBuffer}, {@link java.nio.LongBuffer} and
+     * {@link java.nio.DoubleBuffer}s in native byte order, read from their
+     * position. The output column uses the same types, except read-only
+     * buffers, and receives results converted to its element type. Inputs must hold at least
+     * {@code rowCount} elements. If a row throws, the rows before it have
+     * already been written.
+     *
+     * @return {@code output}
+     */
+    public <T> T mapBatch(JSValue fn, Object[] columns, int rowCount, T output) {
+        return mapBatch(fn, columns, rowCount, output, JSExecutionLimit.NO_LIMIT, JSExecutionLimit.NO_LIMIT);
+    }
+
+    /** As {@link #mapBatch(JSValue, Object[], int, Object)}, with a limit on the whole batch. */
+    public <T> T mapBatch(JSValue fn, Object[] columns, int rowCount, T output, JSExecutionLimit limit) {
+        return mapBatch(fn, columns, rowCount, output, limit.remainingMicros(), limit.interruptChecks());
+    }
 
-        NativeContextCleaner(long ptr) {
-            this.ptr = ptr;
+    private <T> T mapBatch(JSValue fn, Object[] columns, int rowCount, T output, long timeoutMicros,
+            long interruptBudget) {
+        runtime.checkThread();
+        checkClosed();
+        fn.checkClosed();
+        if (rowCount < 0) {
+            throw new IllegalArgumentException("rowCount must not be negative");
+        }
+        Object[] nativeColumns = new Object[columns.length];
+        StringBuilder kinds = new StringBuilder(columns.length);
+        for (int i = 0; i < columns.length; i++) {
+            nativeColumns[i] = batchColumn(columns[i], rowCount);
+            kinds.append(batchKind(nativeColumns[i]));
+        }
+        if (output instanceof java.nio.Buffer && ((java.nio.Buffer) output).isReadOnly()) {
+            throw new IllegalArgumentException("Output buffer must not be read-only");
+        }
+        Object nativeOutput = batchColumn(output, rowCount);
+        try {
+            mapBatchInternal(ptr, fn.ptr, nativeColumns, kinds.toString(), rowCount, nativeOutput,
+                    batchKind(nativeOutput), timeoutMicros, interruptBudget);
+        } finally {
+            runtime.afterInvocation();
+        }
+        return output;
+    }
+
+    // Check a batch column's size, rebasing direct buffers at their position
+    private static Object batchColumn(Object column, int rowCount) {
+        char kind = batchKind(column);
+        int length;
+        if (Character.isLowerCase(kind)) {
+            java.nio.Buffer buffer = (java.nio.Buffer) column;
+            java.nio.ByteOrder order;
+            if (column instanceof java.nio.IntBuffer) {
+                order = ((java.nio.IntBuffer) column).order();
+                column = ((java.nio.IntBuffer) column).slice();
+            } else if (column instanceof java.nio.LongBuffer) {
+                order = ((java.nio.LongBuffer) column).order();
+                column = ((java.nio.LongBuffer) column).slice();
+            } else {
+                order = ((java.nio.DoubleBuffer) column).order();
+                column = ((java.nio.DoubleBuffer) column).slice();
+            }
+            if (!buffer.isDirect() || order != java.nio.ByteOrder.nativeOrder()) {
+                throw new IllegalArgumentException("Buffer columns must be direct and in native byte order");
+            }
+            length = buffer.remaining();
+        } else {
+            length = java.lang.reflect.Array.getLength(column);
+        }
+        if (length < rowCount) {
+            throw new IllegalArgumentException("Batch column has " + length + " elements, need " + rowCount);
         }
+        return column;
+    }
 
-        @Override
-        public void run() {
-            freeNativeContext(ptr);
+    private static char batchKind(Object column) {
+        if (column instanceof int[]) {
+            return 'I';
+        } else if (column instanceof long[]) {
+            return 'J';
+        } else if (column instanceof double[]) {
+            return 'D';
+        } else if (column instanceof boolean[]) {
+            return 'Z';
+        } else if (column instanceof String[]) {
+            return 'S';
+        } else if (column instanceof java.nio.IntBuffer) {
+            return 'i';
+        } else if (column instanceof java.nio.LongBuffer) {
+            return 'j';
+        } else if (column instanceof java.nio.DoubleBuffer) {
+            return 'd';
         }
+        throw new IllegalArgumentException("Unsupported batch column: " + column);
     }
 
     public JSValue createArray() {
@@ -191,10 +441,18 @@ public class JSContext implements AutoCloseable {
         throw new IllegalArgumentException("Unsupported type: " + o.getClass());
     }
 
-    private native long evalInternal(long contextPtr, String script, String fileName, int type);
+    private native long evalInternal(long contextPtr, String script, String fileName, int type, long timeoutMicros,
+            long interruptBudget);
 
     private native long parseJSONInternal(long contextPtr, String json);
 
+    private native long deserializeInternal(long contextPtr, byte[] data, int offset, int length);
+
+    private native long readMessageInternal(long contextPtr, long message);
+
+    private native long deserializeDirectInternal(long contextPtr, java.nio.ByteBuffer buffer, int offset,
+            int length);
+
     private native long createFunctionInternal(long contextPtr, Object callback, String name, int argCount);
 
     private native long createIntegerInternal(long contextPtr, int value);
@@ -203,6 +461,11 @@ public class JSContext implements AutoCloseable {
 
     private native long getGlobalObjectInternal(long contextPtr);
 
+    private native void installConsoleInternal(long contextPtr, long ringPtr, String source);
+
+    private native void mapBatchInternal(long contextPtr, long funcPtr, Object[] columns, String kinds,
+            int rowCount, Object output, char outputKind, long timeoutMicros, long interruptBudget);
+
     private native long createArrayInternal(long contextPtr);
 
     private native long createObjectInternal(long contextPtr);
@@ -219,7 +482,12 @@ public class JSContext implements AutoCloseable {
 
     private native void registerJavaContext(long contextPtr, JSContext thiz);
 
-    private static native void freeNativeContext(long contextPtr);
+    private native void installExportClassInternal(long contextPtr, long classHandle);
+
+    private native long newExportObjectInternal(long contextPtr, long classHandle, Object target);
+
+    private native long createViewInternal(long contextPtr, Object collection, boolean writable);
+
 
     public JSValue createPromise(java.util.concurrent.CompletableFuture<?> future) {
         runtime.checkThread();
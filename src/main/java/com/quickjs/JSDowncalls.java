@@ -0,0 +1,64 @@
+package com.quickjs;
+
+/**
+ * Trivial, non-allocating native operations that can bypass JNI.
+ *
+ * <p>
+ * This is the Java 11 version, which leaves {@link #ENABLED} false so callers
+ * keep using their JNI natives. The multi-release jar carries a JDK 22+
+ * version in {@code META-INF/versions/22} that binds the same operations as
+ * (mostly critical) Foreign Function & Memory downcalls. Both versions must
+ * keep the same members.
+ */
+final class JSDowncalls {
+    // Value tags, as returned by JSValue.getTypeTag()
+    static final int TAG_STRING = -7;
+    static final int TAG_OBJECT = -1;
+    static final int TAG_INT = 0;
+    static final int TAG_BOOL = 1;
+    static final int TAG_NULL = 2;
+    static final int TAG_UNDEFINED = 3;
+    static final int TAG_FLOAT64 = 8;
+
+    /**
+     * Constant per class version, so the JIT drops the branch not taken. It
+     * must not be a compile-time constant, or javac would inline this
+     * version's value into callers and the JDK 22+ class would never be used.
+     */
+    static final boolean ENABLED = enabled();
+
+    private JSDowncalls() {
+    }
+
+    private static boolean enabled() {
+        return false;
+    }
+
+    static int tag(long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static int getInt(long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static double getFloat64(long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static boolean isArray(long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static boolean isFunction(long contextPtr, long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static boolean isError(long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+
+    static void freeValue(long runtimePtr, long valPtr) {
+        throw new UnsupportedOperationException();
+    }
+}
@@ -0,0 +1,88 @@
+package com.quickjs;
+
+import java.time.Duration;
+
+/**
+ * Bounds a single {@code eval} or {@code call} without a watchdog thread.
+ * Limits are enforced by the runtime's interrupt handler, which QuickJS polls
+ * periodically while bytecode runs, so a limit is noticed at the next poll
+ * rather than at the exact instant it expires. Exceeding a limit aborts the
+ * script with {@link JSTimeoutException}.
+ */
+public final class JSExecutionLimit {
+    static final long NO_LIMIT = -1;
+
+    private final long deadlineNanos;
+    private final boolean hasDeadline;
+    private final long interruptChecks;
+
+    private JSExecutionLimit(boolean hasDeadline, long deadlineNanos, long interruptChecks) {
+        this.hasDeadline = hasDeadline;
+        this.deadlineNanos = deadlineNanos;
+        this.interruptChecks = interruptChecks;
+    }
+
+    /**
+     * Stop the script once {@code timeout} has elapsed from the start of the
+     * invocation.
+     */
+    public static JSExecutionLimit timeout(Duration timeout) {
+        return deadline(System.nanoTime() + timeout.toNanos());
+    }
+
+    /**
+     * Stop the script at an absolute deadline expressed in
+     * {@link System#nanoTime()} units. Handy for sharing one request deadline
+     * across several calls.
+     */
+    public static JSExecutionLimit deadline(long deadlineNanos) {
+        return new JSExecutionLimit(true, deadlineNanos, NO_LIMIT);
+    }
+
+    /**
+     * Stop the script at its {@code checks}-th interrupt poll. Unlike a timeout
+     * this is deterministic, so the same script fails at the same point on
+     * every run.
+     */
+    public static JSExecutionLimit interruptChecks(long checks) {
+        if (checks < 0) {
+            throw new IllegalArgumentException("checks must not be negative");
+        }
+        return new JSExecutionLimit(false, 0, checks);
+    }
+
+    public JSExecutionLimit withTimeout(Duration timeout) {
+        return withDeadline(System.nanoTime() + timeout.toNanos());
+    }
+
+    public JSExecutionLimit withDeadline(long deadlineNanos) {
+        return new JSExecutionLimit(true, deadlineNanos, interruptChecks);
+    }
+
+    public JSExecutionLimit withInterruptChecks(long checks) {
+        if (checks < 0) {
+            throw new IllegalArgumentException("checks must not be negative");
+        }
+        return new JSExecutionLimit(hasDeadline, deadlineNanos, checks);
+    }
+
+    /**
+     * @return microseconds left until the deadline, {@link #NO_LIMIT} if there
+     *         is none.
+     * @throws JSTimeoutException if the deadline has already passed.
+     */
+    long remainingMicros() {
+        if (!hasDeadline) {
+            return NO_LIMIT;
+        }
+        long remaining = deadlineNanos - System.nanoTime();
+        if (remaining <= 0) {
+            throw new JSTimeoutException("JS execution exceeded its deadline");
+        }
+        return remaining / 1000;
+    }
+
+    long interruptChecks() {
+        return interruptChecks;
+    }
+}
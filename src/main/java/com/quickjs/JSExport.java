@@ -0,0 +1,32 @@
+package com.quickjs;
+
+import java.lang.annotation.ElementType;
+import java.lang.annotation.Retention;
+import java.lang.annotation.RetentionPolicy;
+import java.lang.annotation.Target;
+
+/**
+ * Exposes a Java class to scripts. At build time
+ * {@link com.quickjs.processor.JSExportProcessor} generates a
+ * {@link JSClassBinding} for every annotated class; instances are then handed
+ * to JS with {@link JSContext#exportObject(Object)}.
+ * <p>
+ * On a class, {@link #value()} names the JS class. On a public instance method,
+ * it names the JS method, and {@link #getter()} exposes a no-argument method as
+ * a read-only property instead. Only plain classes can be exported, not
+ * interfaces, enums or records, and JS names must be unique within a class, so
+ * Java overloads need distinct {@link #value()}s. Parameters and return
+ * values may be {@code boolean}, {@code int}, {@code long}, {@code float},
+ * {@code double} or {@code String}; methods may also return {@code void}.
+ */
+@Retention(RetentionPolicy.SOURCE)
+@Target({ ElementType.TYPE, ElementType.METHOD })
+public @interface JSExport {
+    /**
+     * JS name. Defaults to the Java name, with a {@code get}/{@code is} prefix
+     * stripped for getters.
+     */
+    String value() default "";
+
+    boolean getter() default false;
+}
@@ -0,0 +1,38 @@
+package com.quickjs;
+
+/**
+ * A Java call site that created {@link JSValue} handles which are still
+ * open, as reported by {@link JSRuntime#liveHandles()}.
+ */
+public final class JSHandleSite {
+    private final StackTraceElement[] stackTrace;
+    private final int liveCount;
+
+    JSHandleSite(StackTraceElement[] stackTrace, int liveCount) {
+        this.stackTrace = stackTrace;
+        this.liveCount = liveCount;
+    }
+
+    /** The caller's stack, innermost frame first, without binding frames. */
+    public StackTraceElement[] getStackTrace() {
+        return stackTrace.clone();
+    }
+
+    /**
+     * Sampled handles created here and not yet freed. With a sample interval
+     * of {@code n}, roughly {@code n} times as many are open.
+     */
+    public int getLiveCount() {
+        return liveCount;
+    }
+
+    @Override
+    public String toString() {
+        StringBuilder sb = new StringBuilder();
+        sb.append(liveCount).append(liveCount == 1 ? " live handle" : " live handles").append(" created at");
+        for (StackTraceElement frame : stackTrace) {
+            sb.append("\n\tat ").append(frame);
+        }
+        return sb.toString();
+    }
+}
@@ -0,0 +1,96 @@
+package com.quickjs;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.stream.Collectors;
+
+/**
+ * Counts the value handles of a runtime that are still open, and for every
+ * {@code sampleInterval}-th one remembers the Java stack that created it.
+ * Only used on the owner thread: handles are created there and freed either
+ * by close() or by draining the release queue, so no locking is needed.
+ */
+final class JSHandleTracker {
+    private static final int MAX_FRAMES = 16;
+
+    // Frames of these classes are skipped so a site starts at the caller
+    private static final Set<String> BINDING_CLASSES = Set.of(
+            "com.quickjs.JSHandleTracker", "com.quickjs.JSReleaseQueue", "com.quickjs.JSValue",
+            "com.quickjs.JSContext", "com.quickjs.JSRuntime", "com.quickjs.JSWorkerGroup");
+
+    private static final StackWalker WALKER = StackWalker.getInstance();
+
+    private final int sampleInterval;
+    private final boolean warnOnClose;
+    private final Map<List<StackTraceElement>, Site> sites = new HashMap<>();
+    private final Site unsampled = new Site(this, List.of());
+    private int untilSample = 1;
+    private int live;
+
+    JSHandleTracker(int sampleInterval, boolean warnOnClose) {
+        this.sampleInterval = sampleInterval;
+        this.warnOnClose = warnOnClose;
+    }
+
+    boolean warnOnClose() {
+        return warnOnClose;
+    }
+
+    int liveCount() {
+        return live;
+    }
+
+    Site track() {
+        live++;
+        if (--untilSample > 0) {
+            unsampled.live++;
+            return unsampled;
+        }
+        untilSample = sampleInterval;
+        List<StackTraceElement> frames = WALKER.walk(s -> s
+                .dropWhile(f -> isBindingFrame(f.getClassName()))
+                .limit(MAX_FRAMES)
+                .map(StackWalker.StackFrame::toStackTraceElement)
+                .collect(Collectors.toList()));
+        Site site = sites.computeIfAbsent(frames, k -> new Site(this, k));
+        site.live++;
+        return site;
+    }
+
+    /** Sampled sites with open handles, most handles first. */
+    List<JSHandleSite> liveSites() {
+        List<JSHandleSite> result = new ArrayList<>(sites.size());
+        for (Site site : sites.values()) {
+            result.add(new JSHandleSite(site.frames.toArray(new StackTraceElement[0]), site.live));
+        }
+        result.sort((a, b) -> Integer.compare(b.getLiveCount(), a.getLiveCount()));
+        return result;
+    }
+
+    private static boolean isBindingFrame(String className) {
+        int nested = className.indexOf('$');
+        return BINDING_CLASSES.contains(nested < 0 ? className : className.substring(0, nested));
+    }
+
+    static final class Site {
+        private final JSHandleTracker tracker;
+        private final List<StackTraceElement> frames;
+        private int live;
+
+        private Site(JSHandleTracker tracker, List<StackTraceElement> frames) {
+            this.tracker = tracker;
+            this.frames = frames;
+        }
+
+        // The tracker may have been replaced since; it is updated regardless
+        void release() {
+            tracker.live--;
+            if (--live == 0 && this != tracker.unsampled) {
+                tracker.sites.remove(frames);
+            }
+        }
+    }
+}
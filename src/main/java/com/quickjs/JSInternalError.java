@@ -4,4 +4,8 @@ public class JSInternalError extends QuickJSException {
     public JSInternalError(String message) {
         super(message);
     }
+
+    JSInternalError(JSValue error) {
+        super(error);
+    }
 }
@@ -0,0 +1,42 @@
+package com.quickjs;
+
+/**
+ * Optional groups of built-in objects a {@link JSContext} can be created
+ * with. The base objects ({@code Object}, {@code Function}, {@code Array},
+ * errors, {@code Math}, {@code String}, {@code Number}, {@code Boolean},
+ * {@code Symbol} and iterators) are always present. Leaving out the rest makes
+ * short-lived contexts cheaper to create and smaller.
+ */
+public enum JSIntrinsic {
+    // Order is shared with the native INTRINSIC_* bits
+    /** {@code Date}. */
+    DATE,
+    /**
+     * {@code eval} and {@code Function(...)} from JS. Without it, {@code eval}
+     * is removed, and {@code Function} and the function constructors
+     * reachable through prototypes throw {@code EvalError}; {@code instanceof
+     * Function} still works. Java's {@link JSContext#eval} and module loading
+     * work either way.
+     */
+    EVAL,
+    /** {@code String.prototype.normalize}. */
+    STRING_NORMALIZE,
+    /** {@code RegExp} and regular expression literals. */
+    REGEXP,
+    /** The {@code JSON} object. */
+    JSON,
+    /** {@code Proxy} and {@code Reflect}. */
+    PROXY,
+    /** {@code Map}, {@code Set}, {@code WeakMap} and {@code WeakSet}. */
+    MAP_SET,
+    /** {@code ArrayBuffer}, {@code SharedArrayBuffer}, {@code DataView}, typed arrays and {@code Atomics}. */
+    TYPED_ARRAYS,
+    /** {@code Promise} and async functions. */
+    PROMISE,
+    /** {@code BigInt}. */
+    BIG_INT,
+    /** {@code WeakRef} and {@code FinalizationRegistry}. */
+    WEAK_REF,
+    /** {@code performance.now()}. */
+    PERFORMANCE
+}
@@ -0,0 +1,11 @@
+package com.quickjs;
+
+/**
+ * Receives the resource usage of each top-level invocation on a runtime with
+ * accounting enabled. Called on the runtime's thread; exceptions it throws
+ * are ignored.
+ */
+@FunctionalInterface
+public interface JSInvocationListener {
+    void onInvocation(JSInvocationStats stats);
+}
@@ -0,0 +1,58 @@
+package com.quickjs;
+
+/**
+ * Resources consumed by one top-level invocation, recorded by
+ * {@link JSRuntime#enableAccounting(JSInvocationListener)}.
+ */
+public final class JSInvocationStats {
+    private final long wallNanos;
+    private final long cpuNanos;
+    private final long allocations;
+    private final long allocatedBytes;
+    private final long interruptChecks;
+
+    JSInvocationStats(long wallNanos, long cpuNanos, long allocations, long allocatedBytes, long interruptChecks) {
+        this.wallNanos = wallNanos;
+        this.cpuNanos = cpuNanos;
+        this.allocations = allocations;
+        this.allocatedBytes = allocatedBytes;
+        this.interruptChecks = interruptChecks;
+    }
+
+    public long getWallNanos() {
+        return wallNanos;
+    }
+
+    /** CPU time of the calling thread, including time spent in Java callbacks. */
+    public long getCpuNanos() {
+        return cpuNanos;
+    }
+
+    /** Engine heap allocations, including those later freed. */
+    public long getAllocations() {
+        return allocations;
+    }
+
+    /**
+     * Bytes allocated from the engine heap, as reported by the system
+     * allocator, including memory later freed. Reallocations count the bytes
+     * they grow by.
+     */
+    public long getAllocatedBytes() {
+        return allocatedBytes;
+    }
+
+    /**
+     * Times the engine polled for interrupts, the unit of
+     * {@link JSExecutionLimit#interruptChecks(long)}.
+     */
+    public long getInterruptChecks() {
+        return interruptChecks;
+    }
+
+    @Override
+    public String toString() {
+        return "JSInvocationStats{wallNanos=" + wallNanos + ", cpuNanos=" + cpuNanos + ", allocations="
+                + allocations + ", allocatedBytes=" + allocatedBytes + ", interruptChecks=" + interruptChecks + "}";
+    }
+}
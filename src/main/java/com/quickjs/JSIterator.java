@@ -0,0 +1,15 @@
+package com.quickjs;
+
+import java.util.Iterator;
+
+/**
+ * An {@link Iterator} over a JS iterable, as returned by
+ * {@link JSValue#iterator()}. Closing it before it is exhausted calls the JS
+ * iterator's {@code return()}, so a generator's {@code finally} blocks run,
+ * and frees the values pulled ahead but not yet returned. Closing an
+ * exhausted or failed iterator does nothing.
+ */
+public interface JSIterator extends Iterator<JSValue>, AutoCloseable {
+    @Override
+    void close();
+}
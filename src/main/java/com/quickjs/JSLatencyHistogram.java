@@ -0,0 +1,113 @@
+package com.quickjs;
+
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.AtomicLongArray;
+
+/**
+ * Latencies in nanoseconds, bucketed log-linearly: each power of two is split
+ * into 8 buckets, so a reported value is within 12.5% of the recorded one.
+ * Recording is lock-free and allocation-free.
+ */
+public final class JSLatencyHistogram {
+    private static final int SUB_BUCKET_BITS = 3;
+    private static final int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    private static final int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    private final AtomicLongArray counts = new AtomicLongArray(BUCKETS);
+    private final AtomicLong count = new AtomicLong();
+    private final AtomicLong total = new AtomicLong();
+    private final AtomicLong max = new AtomicLong();
+
+    JSLatencyHistogram() {
+    }
+
+    void record(long nanos) {
+        if (nanos < 0) {
+            nanos = 0;
+        }
+        counts.incrementAndGet(index(nanos));
+        count.incrementAndGet();
+        total.addAndGet(nanos);
+        max.accumulateAndGet(nanos, Math::max);
+    }
+
+    public long getCount() {
+        return count.get();
+    }
+
+    public long getMax() {
+        return max.get();
+    }
+
+    public double getMean() {
+        long n = count.get();
+        return n == 0 ? 0 : (double) total.get() / n;
+    }
+
+    /**
+     * @param percentile between 0 and 100.
+     * @return the upper bound of the bucket holding the given percentile, capped
+     *         at {@link #getMax()}; 0 if nothing was recorded.
+     */
+    public long getValueAtPercentile(double percentile) {
+        if (percentile < 0 || percentile > 100) {
+            throw new IllegalArgumentException("percentile must be between 0 and 100");
+        }
+        long n = 0;
+        long[] snapshot = new long[BUCKETS];
+        for (int i = 0; i < BUCKETS; i++) {
+            snapshot[i] = counts.get(i);
+            n += snapshot[i];
+        }
+        if (n == 0) {
+            return 0;
+        }
+        long rank = Math.max(1, (long) Math.ceil(percentile / 100 * n));
+        long seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += snapshot[i];
+            if (seen >= rank) {
+                return Math.min(upperBound(i), max.get());
+            }
+        }
+        return max.get();
+    }
+
+    public void reset() {
+        for (int i = 0; i < BUCKETS; i++) {
+            counts.set(i, 0);
+        }
+        count.set(0);
+        total.set(0);
+        max.set(0);
+    }
+
+    @Override
+    public String toString() {
+        return String.format("count=%d mean=%.0fns p50=%dns p99=%dns max=%dns", getCount(), getMean(),
+                getValueAtPercentile(50), getValueAtPercentile(99), getMax());
+    }
+
+    // Values below SUB_BUCKETS get a bucket each; above that, the top
+    // SUB_BUCKET_BITS bits after the leading one pick the bucket within the
+    // value's power of two.
+    static int index(long value) {
+        if (value < SUB_BUCKETS) {
+            return (int) value;
+        }
+        int exp = 64 - Long.numberOfLeadingZeros(value);
+        int shift = exp - 1 - SUB_BUCKET_BITS;
+        return (exp - SUB_BUCKET_BITS) * SUB_BUCKETS + (int) ((value >>> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static long upperBound(int index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int exp = index / SUB_BUCKETS + SUB_BUCKET_BITS;
+        int shift = exp - 1 - SUB_BUCKET_BITS;
+        long lowest = ((long) (SUB_BUCKETS + index % SUB_BUCKETS)) << shift;
+        long width = 1L << shift;
+        return lowest + width - 1 < 0 ? Long.MAX_VALUE : lowest + width - 1;
+    }
+}
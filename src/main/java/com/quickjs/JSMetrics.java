@@ -0,0 +1,39 @@
+package com.quickjs;
+
+/**
+ * Per-runtime latency histograms, fed by the Java timing hooks and by native
+ * code for operations that start inside the engine.
+ */
+final class JSMetrics {
+    private static final JSOperation[] OPERATIONS = JSOperation.values();
+
+    private final JSLatencyHistogram[] histograms = new JSLatencyHistogram[OPERATIONS.length];
+    private final JSMetricsListener listener;
+
+    JSMetrics(JSMetricsListener listener) {
+        this.listener = listener;
+        for (int i = 0; i < histograms.length; i++) {
+            histograms[i] = new JSLatencyHistogram();
+        }
+    }
+
+    JSLatencyHistogram histogram(JSOperation operation) {
+        return histograms[operation.ordinal()];
+    }
+
+    void record(JSOperation operation, String fileName, String functionName, long nanos) {
+        histograms[operation.ordinal()].record(nanos);
+        if (listener != null) {
+            try {
+                listener.onOperation(operation, fileName, functionName, nanos);
+            } catch (RuntimeException e) {
+                // A broken listener must not fail the operation it observed
+            }
+        }
+    }
+
+    // Called from native code with the OP_* code of the operation
+    void record(int operation, String fileName, String functionName, long nanos) {
+        record(OPERATIONS[operation], fileName, functionName, nanos);
+    }
+}
@@ -0,0 +1,24 @@
+package com.quickjs;
+
+/**
+ * Receives every operation timed on a runtime with metrics enabled. Called on
+ * the runtime's thread, inside the operation's caller, so it should be cheap;
+ * exceptions it throws are ignored.
+ */
+@FunctionalInterface
+public interface JSMetricsListener {
+    /**
+     * @param fileName     the script or module file, or null if unknown.
+     * @param functionName the JS function or host callback name, or null.
+     */
+    void onOperation(JSOperation operation, String fileName, String functionName, long durationNanos);
+
+    /**
+     * A listener that emits a {@code com.quickjs.Operation} JDK Flight Recorder
+     * event per operation, so JS time shows up next to GC and allocation events
+     * in a recording.
+     */
+    static JSMetricsListener flightRecorder() {
+        return JSOperationEvent::emit;
+    }
+}
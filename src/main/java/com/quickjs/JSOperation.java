@@ -0,0 +1,20 @@
+package com.quickjs;
+
+/**
+ * Operations timed by {@link JSRuntime#enableMetrics(JSMetricsListener)}.
+ */
+public enum JSOperation {
+    // Order is shared with the native OP_* codes
+    /** {@link JSContext#eval} of a script or module. */
+    EVAL,
+    /** {@link JSValue#call} of a JS function from Java. */
+    CALL,
+    /** A Java {@link JSFunction} called from JS. */
+    HOST_CALLBACK,
+    /** A {@link JSModuleLoader} resolving a module. */
+    MODULE_LOAD,
+    /** {@link JSRuntime#runGC()}. */
+    GC,
+    /** {@link JSRuntime#runEventLoop()}. */
+    EVENT_LOOP
+}
@@ -0,0 +1,41 @@
+package com.quickjs;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Event;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+import jdk.jfr.StackTrace;
+import jdk.jfr.Timespan;
+
+@Name("com.quickjs.Operation")
+@Label("QuickJS Operation")
+@Description("An eval, call, host callback, module load, GC or event loop run on a QuickJS runtime")
+@Category("QuickJS")
+@StackTrace(false)
+final class JSOperationEvent extends Event {
+    @Label("Operation")
+    String operation;
+
+    @Label("File")
+    String fileName;
+
+    @Label("Function")
+    String functionName;
+
+    @Label("Duration")
+    @Timespan(Timespan.NANOSECONDS)
+    long duration;
+
+    static void emit(JSOperation operation, String fileName, String functionName, long durationNanos) {
+        JSOperationEvent event = new JSOperationEvent();
+        if (!event.shouldCommit()) {
+            return;
+        }
+        event.operation = operation.name();
+        event.fileName = fileName;
+        event.functionName = functionName;
+        event.duration = durationNanos;
+        event.commit();
+    }
+}
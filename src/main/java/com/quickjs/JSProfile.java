@@ -0,0 +1,54 @@
+package com.quickjs;
+
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * Samples collected by {@link JSRuntime#startProfiling(long)}.
+ * Stacks use the collapsed format understood by flamegraph.pl and speedscope:
+ * frames are separated by {@code ;}, outermost first, each frame being
+ * {@code function (file:line)}.
+ */
+public final class JSProfile {
+    private final Map<String, Long> stacks = new LinkedHashMap<>();
+    private long sampleCount;
+
+    JSProfile(String collapsed) {
+        if (collapsed == null) {
+            return;
+        }
+        for (String line : collapsed.split("\n")) {
+            int sep = line.lastIndexOf(' ');
+            if (sep <= 0) {
+                continue;
+            }
+            long count = Long.parseLong(line.substring(sep + 1));
+            stacks.merge(line.substring(0, sep), count, Long::sum);
+            sampleCount += count;
+        }
+    }
+
+    /**
+     * @return sample counts keyed by collapsed stack.
+     */
+    public Map<String, Long> getStacks() {
+        return Collections.unmodifiableMap(stacks);
+    }
+
+    public long getSampleCount() {
+        return sampleCount;
+    }
+
+    /**
+     * @return the profile as collapsed-stack text, one {@code stack count} line
+     *         per distinct stack.
+     */
+    public String toCollapsedStacks() {
+        StringBuilder sb = new StringBuilder();
+        for (Map.Entry<String, Long> entry : stacks.entrySet()) {
+            sb.append(entry.getKey()).append(' ').append(entry.getValue()).append('\n');
+        }
+        return sb.toString();
+    }
+}
@@ -4,4 +4,8 @@ public class JSRangeError extends QuickJSException {
     public JSRangeError(String message) {
         super(message);
     }
+
+    JSRangeError(JSValue error) {
+        super(error);
+    }
 }
@@ -4,4 +4,8 @@ public class JSReferenceError extends QuickJSException {
     public JSReferenceError(String message) {
         super(message);
     }
+
+    JSReferenceError(JSValue error) {
+        super(error);
+    }
 }
@@ -0,0 +1,200 @@
+package com.quickjs;
+
+import java.util.concurrent.atomic.AtomicReference;
+
+/**
+ * Native handles of a runtime waiting to be freed on its owner thread.
+ *
+ * <p>
+ * A {@link JSValue} or {@link JSContext} that is closed on the owner thread is
+ * freed immediately. One that is only garbage collected is pushed here by the
+ * {@link java.lang.ref.Cleaner} thread instead, since the engine is not
+ * thread-safe, and freed in one native call the next time the owner thread
+ * reaches a safe point ({@code eval}, {@code runEventLoop} or {@code close}).
+ * The queue is a lock-free stack linked through the cleaning actions
+ * themselves, so deferring a handle allocates nothing.
+ */
+final class JSReleaseQueue {
+    private final long runtimePtr;
+    private final Thread ownerThread;
+    private final AtomicReference<Handle> head = new AtomicReference<>();
+    // Every handle not yet freed, linked through prevLive/nextLive, so the runtime's
+    // own cleaner can free what the owner thread never got to. Only touched
+    // on the owner thread, and by freeAll() once nothing else can run.
+    private Handle live;
+    private volatile boolean freed;
+    // Null unless handle tracking is on; only read and written on the owner thread
+    JSHandleTracker tracker;
+
+    JSReleaseQueue(long runtimePtr, Thread ownerThread) {
+        this.runtimePtr = runtimePtr;
+        this.ownerThread = ownerThread;
+    }
+
+    Handle value(long valPtr) {
+        Handle handle = new Handle(this, valPtr, false);
+        if (tracker != null) {
+            handle.site = tracker.track();
+        }
+        return handle;
+    }
+
+    Handle context(long contextPtr) {
+        return new Handle(this, contextPtr, true);
+    }
+
+    /**
+     * Free every handle still open, deferred or not, and drop any pushed
+     * later. Called by the runtime's cleaner just before the engine is freed:
+     * the runtime is unreachable then, so its owner thread no longer uses
+     * these handles, but handles that became unreachable with it may not have
+     * been cleaned yet.
+     */
+    void freeAll() {
+        freed = true;
+        head.set(null);
+        int valueCount = 0;
+        int contextCount = 0;
+        for (Handle h = live; h != null; h = h.nextLive) {
+            if (h.context) {
+                contextCount++;
+            } else {
+                valueCount++;
+            }
+        }
+        long[] values = new long[valueCount];
+        long[] contexts = new long[contextCount];
+        valueCount = 0;
+        contextCount = 0;
+        for (Handle h = live; h != null; h = h.nextLive) {
+            if (h.context) {
+                contexts[contextCount++] = h.ptr;
+            } else {
+                values[valueCount++] = h.ptr;
+            }
+        }
+        live = null;
+        releaseInternal(runtimePtr, values, contexts);
+    }
+
+    boolean isFreed() {
+        return freed;
+    }
+
+    boolean isEmpty() {
+        return head.get() == null;
+    }
+
+    /** Free every deferred handle. Must be called on the owner thread. */
+    void drain() {
+        if (head.get() == null) {
+            return;
+        }
+        Handle first = head.getAndSet(null);
+        int valueCount = 0;
+        int contextCount = 0;
+        for (Handle h = first; h != null; h = h.next) {
+            if (h.context) {
+                contextCount++;
+            } else {
+                valueCount++;
+            }
+        }
+        long[] values = new long[valueCount];
+        long[] contexts = new long[contextCount];
+        valueCount = 0;
+        contextCount = 0;
+        for (Handle h = first; h != null; h = h.next) {
+            if (h.context) {
+                contexts[contextCount++] = h.ptr;
+            } else {
+                values[valueCount++] = h.ptr;
+                h.untrack();
+            }
+            h.unlink();
+        }
+        // Values first, so the contexts they belong to are freed last
+        releaseInternal(runtimePtr, values, contexts);
+    }
+
+    private void push(Handle handle) {
+        if (freed) {
+            // Already freed with the runtime
+            return;
+        }
+        Handle current;
+        do {
+            current = head.get();
+            handle.next = current;
+        } while (!head.compareAndSet(current, handle));
+    }
+
+    static final class Handle implements Runnable {
+        private final JSReleaseQueue queue;
+        private final long ptr;
+        private final boolean context;
+        private Handle next;
+        private Handle prevLive;
+        private Handle nextLive;
+        private JSHandleTracker.Site site;
+
+        // Created on the owner thread
+        private Handle(JSReleaseQueue queue, long ptr, boolean context) {
+            this.queue = queue;
+            this.ptr = ptr;
+            this.context = context;
+            nextLive = queue.live;
+            if (nextLive != null) {
+                nextLive.prevLive = this;
+            }
+            queue.live = this;
+        }
+
+        private void unlink() {
+            if (prevLive != null) {
+                prevLive.nextLive = nextLive;
+            } else {
+                queue.live = nextLive;
+            }
+            if (nextLive != null) {
+                nextLive.prevLive = prevLive;
+            }
+            prevLive = null;
+            nextLive = null;
+        }
+
+        // Runs at most once: from close() on the owner thread, or from the
+        // Cleaner thread once the owning JSValue/JSContext is unreachable
+        @Override
+        public void run() {
+            if (Thread.currentThread() != queue.ownerThread) {
+                queue.push(this);
+                return;
+            }
+            unlink();
+            if (context) {
+                freeContextInternal(ptr);
+            } else {
+                if (JSDowncalls.ENABLED) {
+                    JSDowncalls.freeValue(queue.runtimePtr, ptr);
+                } else {
+                    freeValueInternal(queue.runtimePtr, ptr);
+                }
+                untrack();
+            }
+        }
+
+        private void untrack() {
+            if (site != null) {
+                site.release();
+                site = null;
+            }
+        }
+    }
+
+    private static native void freeValueInternal(long runtimePtr, long valPtr);
+
+    private static native void freeContextInternal(long contextPtr);
+
+    private static native void releaseInternal(long runtimePtr, long[] values, long[] contexts);
+}
@@ -1,22 +1,28 @@
 package com.quickjs;
 
 import java.lang.ref.Cleaner;
+import java.util.EnumSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
 
 public class JSRuntime implements AutoCloseable {
     private long ptr;
     private final Thread ownerThread;
     private final Cleaner.Cleanable cleanable;
+    private final JSReleaseQueue releaseQueue;
     private final java.util.Queue<Runnable> jobQueue = new java.util.concurrent.ConcurrentLinkedQueue<>();
     private volatile boolean closed = false;
 
     JSRuntime(long ptr) {
         this.ptr = ptr;
         this.ownerThread = Thread.currentThread();
-        this.cleanable = QuickJS.cleaner.register(this, new NativeRuntimeCleaner(ptr));
+        this.releaseQueue = new JSReleaseQueue(ptr, ownerThread);
+        this.cleanable = QuickJS.cleaner.register(this, new NativeRuntimeCleaner(ptr, releaseQueue));
     }
 
     public static JSRuntime create() {
-        return new JSRuntime(createRuntimeInternal());
+        return QuickJS.createRuntime();
     }
 
     public long getPtr() {
@@ -25,21 +31,101 @@ public class JSRuntime implements AutoCloseable {
     }
 
     public JSContext createContext() {
+        return createContext(defaultIntrinsics);
+    }
+
+    /**
+     * Create a context with the base objects plus {@code intrinsics}, e.g.
+     * {@code EnumSet.of(JSIntrinsic.JSON)} for one that only evaluates
+     * expressions over JSON data.
+     */
+    public JSContext createContext(Set<JSIntrinsic> intrinsics) {
         checkThread();
         checkClosed();
-        long contextPtr = createNativeContext(ptr, withStdLib);
+        int mask = 0;
+        for (JSIntrinsic intrinsic : intrinsics) {
+            mask |= 1 << intrinsic.ordinal();
+        }
+        long contextPtr = createNativeContext(ptr, mask);
         if (contextPtr == 0) {
             throw new RuntimeException("Failed to create QuickJS context");
         }
-        return new JSContext(contextPtr, this);
+        JSContext context = new JSContext(contextPtr, this);
+        if (!sharedNames.isEmpty()) {
+            try {
+                installSharedInternal(contextPtr, 0);
+            } catch (RuntimeException e) {
+                context.close();
+                throw e;
+            }
+        }
+        contexts.put(context, Boolean.TRUE);
+        return context;
+    }
+
+    /**
+     * Copy {@code value} into a context private to this runtime, deep-freeze
+     * the copy and define it as the read-only global {@code name} in every
+     * context of this runtime, current and future. Contexts share the one
+     * frozen object graph instead of each parsing its own copy, and it stays
+     * alive until the runtime closes.
+     * <p>
+     * The value is copied like {@link JSValue#serialize()}, so it must be
+     * data: functions are rejected, and {@code value} itself is left as it
+     * was. Shared objects inherit from the private context's built-ins,
+     * which are frozen with them, so no context can change what they
+     * inherit, and {@code instanceof Object} is false for them in the
+     * contexts scripts use. Nothing is shared if freezing fails, for example
+     * on a non-empty typed array.
+     *
+     * @throws IllegalArgumentException if an open context already has a
+     *                                  non-configurable global {@code name},
+     *                                  such as {@code undefined} or a
+     *                                  {@code var}
+     */
+    public void shareFrozen(String name, JSValue value) {
+        checkThread();
+        checkClosed();
+        value.checkClosed();
+        JSContext owner = value.getContext();
+        if (owner.getRuntime() != this) {
+            throw new IllegalArgumentException("Value belongs to a different runtime");
+        }
+        if (sharedNames.contains(name)) {
+            throw new IllegalStateException("Already shared: " + name);
+        }
+        // Check every context first: the globals are non-configurable, so one
+        // installed cannot be taken back if a later context refuses it
+        for (JSContext context : contexts.keySet()) {
+            if (context.ptr != 0 && !canShareInternal(context.ptr, name)) {
+                throw new IllegalArgumentException("Cannot define global " + name + ": a context has a "
+                        + "non-configurable property of that name");
+            }
+        }
+        shareFrozenInternal(owner.ptr, name, value.ptr);
+        sharedNames.add(name);
+        int index = sharedNames.size() - 1;
+        for (JSContext context : contexts.keySet()) {
+            if (context.ptr != 0) {
+                installSharedInternal(context.ptr, index);
+            }
+        }
     }
 
     public void checkThread() {
-        if (Thread.currentThread() != ownerThread) {
+        if (!isOwnerThread()) {
             throw new IllegalStateException("JSRuntime used on wrong thread. Access is single-threaded.");
         }
     }
 
+    boolean isOwnerThread() {
+        return Thread.currentThread() == ownerThread;
+    }
+
+    JSReleaseQueue releaseQueue() {
+        return releaseQueue;
+    }
+
     private void checkClosed() {
         if (closed) {
             throw new IllegalStateException("JSRuntime is closed");
@@ -64,6 +150,10 @@ public class JSRuntime implements AutoCloseable {
         checkThread();
         checkClosed();
 
+        JSMetrics metrics = this.metrics;
+        long start = metrics != null ? System.nanoTime() : 0;
+        releaseQueue.drain();
+
         // 1. Process Java jobs (e.g. CompletableFuture callbacks)
         Runnable job;
         while ((job = jobQueue.poll()) != null) {
@@ -75,27 +165,43 @@ public class JSRuntime implements AutoCloseable {
         }
 
         // 2. Process QuickJS pending jobs (Microtasks/Promises)
-        while (executePendingJobInternal(ptr))
-            ;
+        try {
+            while (executePendingJobInternal(ptr))
+                ;
+        } finally {
+            if (metrics != null) {
+                metrics.record(JSOperation.EVENT_LOOP, null, null, System.nanoTime() - start);
+            }
+        }
     }
 
     @Override
     public void close() {
         if (!closed) {
+            if (isOwnerThread()) {
+                releaseQueue.drain();
+                warnOfLiveHandles();
+            }
             closed = true;
-            // Native cleaner will handle freeRuntimeInternal(ptr);
+            // The runtime cleaner frees what is still queued, then the runtime
         }
     }
 
     private static class NativeRuntimeCleaner implements Runnable {
         private final long ptr;
+        private final JSReleaseQueue releaseQueue;
 
-        NativeRuntimeCleaner(long ptr) {
+        NativeRuntimeCleaner(long ptr, JSReleaseQueue releaseQueue) {
             this.ptr = ptr;
+            this.releaseQueue = releaseQueue;
         }
 
+        // Contexts and values that became unreachable with the runtime, or
+        // were collected after close(), may still hold engine objects, which
+        // JS_FreeRuntime requires to be gone
         @Override
         public void run() {
+            releaseQueue.freeAll();
             freeRuntimeInternal(ptr);
         }
     }
@@ -109,6 +215,33 @@ public class JSRuntime implements AutoCloseable {
         setModuleLoaderInternal(ptr, loader);
     }
 
+    /**
+     * Make {@code exports} importable from every context of this runtime as
+     * the module {@code name}, e.g. {@code import { query } from "host:db"}.
+     * Nothing is created in a context until it first imports the module, so
+     * contexts pay only for the modules they use. Host modules are looked up
+     * before the {@link JSModuleLoader}, and a name can be registered once.
+     */
+    public void registerHostModule(String name, Map<String, JSFunction> exports) {
+        checkThread();
+        checkClosed();
+        if (!hostModules.add(name)) {
+            throw new IllegalStateException("Host module already registered: " + name);
+        }
+        String[] exportNames = new String[exports.size()];
+        JSFunction[] functions = new JSFunction[exports.size()];
+        int i = 0;
+        for (Map.Entry<String, JSFunction> export : exports.entrySet()) {
+            exportNames[i] = export.getKey();
+            functions[i] = export.getValue();
+            i++;
+        }
+        if (!registerHostModuleInternal(ptr, name, exportNames, functions)) {
+            hostModules.remove(name);
+            throw new QuickJSException("Failed to register host module " + name);
+        }
+    }
+
     public void setMemoryLimit(long limit) {
         checkThread();
         checkClosed();
@@ -137,11 +270,249 @@ public class JSRuntime implements AutoCloseable {
         clearInterruptInternal(ptr);
     }
 
+    // Allow Atomics.wait to block this runtime's thread; only worker threads opt in
+    void setCanBlock(boolean canBlock) {
+        checkThread();
+        checkClosed();
+        setCanBlockInternal(ptr, canBlock);
+    }
+
+    /**
+     * Start sampling the JS call stack of scripts running on this runtime.
+     * Samples are taken from the interrupt handler at most once every
+     * {@code intervalMicros} microseconds of script execution, so an idle
+     * runtime costs nothing. Restarting discards any samples not yet collected.
+     */
+    public void startProfiling(long intervalMicros) {
+        checkThread();
+        checkClosed();
+        if (intervalMicros <= 0) {
+            throw new IllegalArgumentException("intervalMicros must be positive");
+        }
+        startProfilingInternal(ptr, intervalMicros);
+    }
+
+    public void startProfiling() {
+        startProfiling(DEFAULT_PROFILING_INTERVAL_MICROS);
+    }
+
+    /**
+     * Stop sampling and return the samples collected since
+     * {@link #startProfiling(long)}.
+     */
+    public JSProfile stopProfiling() {
+        checkThread();
+        checkClosed();
+        return new JSProfile(stopProfilingInternal(ptr));
+    }
+
+    public static final long DEFAULT_PROFILING_INTERVAL_MICROS = 1000;
+
+    // Null while metrics are disabled, so instrumented paths cost one field read
+    private JSMetrics metrics;
+
+    /** Record latency histograms for binding operations, without a listener. */
+    public void enableMetrics() {
+        enableMetrics(null);
+    }
+
+    /**
+     * Time eval, call, host callbacks, module loads, explicit GC runs and
+     * event loop iterations on this runtime. Each operation is added to a
+     * per-operation {@link JSLatencyHistogram} and, if {@code listener} is not
+     * null, reported to it with its file and function name. Re-enabling
+     * starts from empty histograms.
+     */
+    public void enableMetrics(JSMetricsListener listener) {
+        checkThread();
+        checkClosed();
+        metrics = new JSMetrics(listener);
+        setMetricsInternal(ptr, metrics);
+    }
+
+    public void disableMetrics() {
+        checkThread();
+        checkClosed();
+        metrics = null;
+        setMetricsInternal(ptr, null);
+    }
+
+    /** Latencies recorded since metrics were enabled. */
+    public JSLatencyHistogram getLatencyHistogram(JSOperation operation) {
+        JSMetrics current = metrics;
+        if (current == null) {
+            throw new IllegalStateException("Metrics are not enabled");
+        }
+        return current.histogram(operation);
+    }
+
+    JSMetrics getMetrics() {
+        return metrics;
+    }
+
+    private boolean accounting;
+    private JSInvocationListener invocationListener;
+    private JSInvocationStats lastInvocationStats;
+
+    /** Record resource usage of each top-level invocation, without a listener. */
+    public void enableAccounting() {
+        enableAccounting(null);
+    }
+
+    /**
+     * Record the wall time, thread CPU time, allocations and interrupt checks
+     * of every top-level {@code eval}, {@code call} and {@code mapBatch} on
+     * this runtime. Invocations nested inside a Java callback count towards
+     * the enclosing one. Stats are available from
+     * {@link #getLastInvocationStats()} and, if {@code listener} is not null,
+     * passed to it as each invocation returns or throws.
+     */
+    public void enableAccounting(JSInvocationListener listener) {
+        checkThread();
+        checkClosed();
+        accounting = true;
+        invocationListener = listener;
+        lastInvocationStats = null;
+        setAccountingInternal(ptr, true);
+    }
+
+    public void disableAccounting() {
+        checkThread();
+        checkClosed();
+        accounting = false;
+        invocationListener = null;
+        setAccountingInternal(ptr, false);
+    }
+
+    /**
+     * @return the stats of the last top-level invocation, or null if none
+     *         finished since accounting was enabled.
+     */
+    public JSInvocationStats getLastInvocationStats() {
+        checkThread();
+        return lastInvocationStats;
+    }
+
+    // Called after each eval/call; only a top-level invocation has new stats
+    void afterInvocation() {
+        if (!accounting) {
+            return;
+        }
+        long[] stats = new long[5];
+        if (!takeInvocationStatsInternal(ptr, stats)) {
+            return;
+        }
+        lastInvocationStats = new JSInvocationStats(stats[0], stats[1], stats[2], stats[3], stats[4]);
+        if (invocationListener != null) {
+            try {
+                invocationListener.onInvocation(lastInvocationStats);
+            } catch (RuntimeException e) {
+                // A broken listener must not fail the invocation it observed
+            }
+        }
+    }
+
+    /**
+     * Track open {@link JSValue} handles, recording the Java stack that
+     * created every {@code sampleInterval}-th one. Sampling every handle
+     * ({@code 1}) finds any leak but walks the stack on each allocation;
+     * larger intervals find the sites that leak most at a fraction of the
+     * cost. Only handles created from now on are tracked.
+     *
+     * @param warnOnClose log a warning listing the open sites if handles are
+     *                    still open when this runtime is closed
+     */
+    public void enableHandleTracking(int sampleInterval, boolean warnOnClose) {
+        checkThread();
+        checkClosed();
+        if (sampleInterval <= 0) {
+            throw new IllegalArgumentException("sampleInterval must be positive");
+        }
+        releaseQueue.tracker = new JSHandleTracker(sampleInterval, warnOnClose);
+    }
+
+    /** Track every handle, and warn if any are open at close. */
+    public void enableHandleTracking() {
+        enableHandleTracking(1, true);
+    }
+
+    public void disableHandleTracking() {
+        checkThread();
+        checkClosed();
+        releaseQueue.tracker = null;
+    }
+
+    /**
+     * Sites that created sampled handles which are still open, most first.
+     * Handles collected by the GC but not yet freed still count; they are
+     * freed at the next {@code eval} or {@link #runEventLoop()}.
+     */
+    public List<JSHandleSite> liveHandles() {
+        checkThread();
+        return tracker().liveSites();
+    }
+
+    /** All tracked handles that are still open, sampled or not. */
+    public int liveHandleCount() {
+        checkThread();
+        return tracker().liveCount();
+    }
+
+    private JSHandleTracker tracker() {
+        JSHandleTracker tracker = releaseQueue.tracker;
+        if (tracker == null) {
+            throw new IllegalStateException("Handle tracking is not enabled");
+        }
+        return tracker;
+    }
+
+    private void warnOfLiveHandles() {
+        JSHandleTracker tracker = releaseQueue.tracker;
+        if (tracker == null || !tracker.warnOnClose() || tracker.liveCount() == 0) {
+            return;
+        }
+        StringBuilder message = new StringBuilder();
+        message.append("JSRuntime closed with ").append(tracker.liveCount()).append(" open JSValue handles");
+        for (JSHandleSite site : tracker.liveSites()) {
+            message.append('\n').append(site);
+        }
+        System.getLogger(JSRuntime.class.getName()).log(System.Logger.Level.WARNING, message.toString());
+    }
+
+    /** Run a full garbage collection cycle now. */
+    public void runGC() {
+        checkThread();
+        checkClosed();
+        runGCInternal(ptr);
+    }
+
+    private final Set<String> hostModules = new java.util.HashSet<>();
+
+    // Open contexts, to define values shared after they were created
+    private final Map<JSContext, Boolean> contexts = new java.util.WeakHashMap<>();
+    private final Set<String> sharedNames = new java.util.HashSet<>();
+
+    // Native class handles of @JSExport bindings, registered once per runtime
+    private final java.util.Map<JSClassBinding, Long> exportClasses = new java.util.HashMap<>();
+
+    long getExportClass(JSClassBinding binding) {
+        Long handle = exportClasses.get(binding);
+        if (handle == null) {
+            handle = registerExportClassInternal(ptr, binding.type, binding.className, binding.jsNames,
+                    binding.javaNames, binding.signatures, binding.getters);
+            if (handle == 0) {
+                throw new QuickJSException("Failed to register JS class " + binding.className);
+            }
+            exportClasses.put(binding, handle);
+        }
+        return handle;
+    }
+
     // Internal config
-    private boolean withStdLib = true;
+    private Set<JSIntrinsic> defaultIntrinsics = EnumSet.allOf(JSIntrinsic.class);
 
-    void setWithStdLib(boolean withStdLib) {
-        this.withStdLib = withStdLib;
+    void setDefaultIntrinsics(Set<JSIntrinsic> intrinsics) {
+        this.defaultIntrinsics = intrinsics;
     }
 
     private native void setMemoryLimitInternal(long runtimePtr, long limit);
@@ -152,13 +523,37 @@ public class JSRuntime implements AutoCloseable {
 
     private native void clearInterruptInternal(long runtimePtr);
 
+    private native void setCanBlockInternal(long runtimePtr, boolean canBlock);
+
+    private native void setMetricsInternal(long runtimePtr, JSMetrics metrics);
+
+    private native void runGCInternal(long runtimePtr);
+
+    private native void setAccountingInternal(long runtimePtr, boolean enabled);
+
+    private native boolean takeInvocationStatsInternal(long runtimePtr, long[] stats);
+
     private native void setModuleLoaderInternal(long runtimePtr, JSModuleLoader loader);
 
-    private static native long createRuntimeInternal();
+    private native void shareFrozenInternal(long contextPtr, String name, long valPtr);
+
+    private native void installSharedInternal(long contextPtr, int first);
+
+    private native boolean canShareInternal(long contextPtr, String name);
+
+    private native boolean registerHostModuleInternal(long runtimePtr, String name, String[] exportNames,
+            JSFunction[] functions);
+
+    private native void startProfilingInternal(long runtimePtr, long intervalMicros);
+
+    private native String stopProfilingInternal(long runtimePtr);
+
+    private native long registerExportClassInternal(long runtimePtr, Class<?> type, String className,
+            String[] jsNames, String[] javaNames, String[] signatures, boolean[] getters);
 
     private static native void freeRuntimeInternal(long ptr);
 
-    private native long createNativeContext(long runtimePtr, boolean withStdLib);
+    private native long createNativeContext(long runtimePtr, int intrinsics);
 
     private static native boolean executePendingJobInternal(long ptr);
 }
@@ -4,4 +4,8 @@ public class JSSyntaxError extends QuickJSException {
     public JSSyntaxError(String message) {
         super(message);
     }
+
+    JSSyntaxError(JSValue error) {
+        super(error);
+    }
 }
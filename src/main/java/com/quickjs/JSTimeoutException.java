@@ -0,0 +1,11 @@
+package com.quickjs;
+
+/**
+ * Thrown when a script exceeds the deadline or interrupt-check budget given by
+ * a {@link JSExecutionLimit}.
+ */
+public class JSTimeoutException extends QuickJSException {
+    public JSTimeoutException(String message) {
+        super(message);
+    }
+}
@@ -4,4 +4,8 @@ public class JSTypeError extends QuickJSException {
     public JSTypeError(String message) {
         super(message);
     }
+
+    JSTypeError(JSValue error) {
+        super(error);
+    }
 }
@@ -11,24 +11,38 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
     JSValue(long ptr, JSContext context) {
         this.ptr = ptr;
         this.context = context;
-        this.cleanable = QuickJS.cleaner.register(this, new NativeValueCleaner(ptr, context.ptr));
+        this.cleanable = QuickJS.cleaner.register(this, context.releaseQueue().value(ptr));
     }
 
     public int asInteger() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED && JSDowncalls.tag(ptr) == JSDowncalls.TAG_INT) {
+            return JSDowncalls.getInt(ptr);
+        }
         return toIntegerInternal(context.ptr, ptr);
     }
 
     public boolean asBoolean() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED && JSDowncalls.tag(ptr) == JSDowncalls.TAG_BOOL) {
+            return JSDowncalls.getInt(ptr) != 0;
+        }
         return toBooleanInternal(context.ptr, ptr);
     }
 
     public double asDouble() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            int tag = JSDowncalls.tag(ptr);
+            if (tag == JSDowncalls.TAG_FLOAT64) {
+                return JSDowncalls.getFloat64(ptr);
+            } else if (tag == JSDowncalls.TAG_INT) {
+                return JSDowncalls.getInt(ptr);
+            }
+        }
         return toDoubleInternal(context.ptr, ptr);
     }
 
@@ -44,9 +58,48 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
         return toJSONInternal(context.ptr, ptr);
     }
 
+    /**
+     * Serialize this value into QuickJS's structured binary format. Unlike
+     * {@link #toJSON()} this keeps types such as {@code Date}, typed arrays and
+     * BigInt, as well as shared references and cycles. The result can be read
+     * by {@link JSContext#deserialize(byte[])} in any runtime of the same
+     * library version. Functions cannot be serialized.
+     */
+    public byte[] serialize() {
+        checkThread();
+        checkClosed();
+        return serializeInternal(context.ptr, ptr);
+    }
+
+    // Lazy QuickJSException support: the exception holds this value as its error
+    void trackException(QuickJSException exception) {
+        context.trackException(exception);
+    }
+
+    boolean isOwnerThread() {
+        return context.isOwnerThread();
+    }
+
+    String describeError() {
+        checkThread();
+        checkClosed();
+        return describeErrorInternal(context.ptr, ptr);
+    }
+
+    // Serialize for another runtime, sharing rather than copying SharedArrayBuffers.
+    // The returned message must be passed to JSContext.readMessage or freed.
+    long writeMessage() {
+        checkThread();
+        checkClosed();
+        return writeMessageInternal(context.ptr, ptr);
+    }
+
     public int getTypeTag() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr);
+        }
         return getTagInternal(context.ptr, ptr);
     }
 
@@ -79,6 +132,18 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
     }
 
     public JSValue call(JSValue thisObj, JSValue... args) {
+        return call(thisObj, JSExecutionLimit.NO_LIMIT, JSExecutionLimit.NO_LIMIT, args);
+    }
+
+    /**
+     * Call this function, aborting it with {@link JSTimeoutException} once it
+     * exceeds {@code limit}.
+     */
+    public JSValue call(JSValue thisObj, JSExecutionLimit limit, JSValue... args) {
+        return call(thisObj, limit.remainingMicros(), limit.interruptChecks(), args);
+    }
+
+    private JSValue call(JSValue thisObj, long timeoutMicros, long interruptBudget, JSValue[] args) {
         checkThread();
         checkClosed();
         long thisPtr = (thisObj != null) ? thisObj.ptr : 0;
@@ -87,8 +152,23 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
             args[i].checkClosed();
             argPtrs[i] = args[i].ptr;
         }
-        long resultPtr = callInternal(context.ptr, ptr, thisPtr, argPtrs);
-        return new JSValue(resultPtr, context);
+        JSMetrics metrics = context.getMetrics();
+        long start = metrics != null ? System.nanoTime() : 0;
+        try {
+            long resultPtr = callInternal(context.ptr, ptr, thisPtr, argPtrs, timeoutMicros, interruptBudget);
+            return new JSValue(resultPtr, context);
+        } finally {
+            if (metrics != null) {
+                metrics.record(JSOperation.CALL, null, functionName(), System.nanoTime() - start);
+            }
+            context.afterInvocation();
+        }
+    }
+
+    // The function's name for metrics tags, or null if it has none. Runs in
+    // call()'s finally block, so it reads natively and never throws
+    private String functionName() {
+        return functionNameInternal(context.ptr, ptr);
     }
 
     @Override
@@ -98,7 +178,11 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
         ptr = 0;
     }
 
-    private void checkClosed() {
+    JSContext getContext() {
+        return context;
+    }
+
+    void checkClosed() {
         if (ptr == 0) {
             throw new IllegalStateException("JSValue is closed");
         }
@@ -221,60 +305,91 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
     public boolean isString() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_STRING;
+        }
         return isStringInternal(context.ptr, ptr);
     }
 
     public boolean isNumber() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            int tag = JSDowncalls.tag(ptr);
+            return tag == JSDowncalls.TAG_INT || tag == JSDowncalls.TAG_FLOAT64;
+        }
         return isNumberInternal(context.ptr, ptr);
     }
 
     public boolean isInteger() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_INT;
+        }
         return isIntegerInternal(context.ptr, ptr);
     }
 
     public boolean isBoolean() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_BOOL;
+        }
         return isBooleanInternal(context.ptr, ptr);
     }
 
     public boolean isArray() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.isArray(ptr);
+        }
         return isArrayInternal(context.ptr, ptr);
     }
 
     public boolean isObject() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_OBJECT;
+        }
         return isObjectInternal(context.ptr, ptr);
     }
 
     public boolean isFunction() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.isFunction(context.ptr, ptr);
+        }
         return isFunctionInternal(context.ptr, ptr);
     }
 
     public boolean isError() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.isError(ptr);
+        }
         return isErrorInternal(context.ptr, ptr);
     }
 
     public boolean isNull() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_NULL;
+        }
         return isNullInternal(context.ptr, ptr);
     }
 
     public boolean isUndefined() {
         checkThread();
         checkClosed();
+        if (JSDowncalls.ENABLED) {
+            return JSDowncalls.tag(ptr) == JSDowncalls.TAG_UNDEFINED;
+        }
         return isUndefinedInternal(context.ptr, ptr);
     }
 
@@ -309,17 +424,102 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
         }
     }
 
+    /**
+     * Iterate the values of any JS iterable (arrays, Maps, Sets, typed arrays,
+     * generators) using the iteration protocol. Values are pulled natively
+     * {@value #ITERATOR_CHUNK_SIZE} at a time, so most {@code next()} calls
+     * do not cross into native code. Objects without {@code Symbol.iterator}
+     * are iterated as array-likes through their {@code length}. The caller
+     * owns, and must close, each returned value. Close the iterator itself
+     * when stopping before the end, so the JS iterator can clean up.
+     */
     @Override
-    public java.util.Iterator<JSValue> iterator() {
+    public JSIterator iterator() {
         checkThread();
         checkClosed();
-        // Assuming array-like
+        long[] nextPtr = new long[1];
+        long iterPtr = iteratorInternal(context.ptr, ptr, nextPtr);
+        if (iterPtr == 0) {
+            return arrayLikeIterator();
+        }
+        JSValue iter = new JSValue(iterPtr, context);
+        JSValue next = new JSValue(nextPtr[0], context);
+
+        return new JSIterator() {
+            private final long[] chunk = new long[ITERATOR_CHUNK_SIZE];
+            // Wrapped straight away so values left unread are still freed
+            private final JSValue[] values = new JSValue[ITERATOR_CHUNK_SIZE];
+            private int index = 0;
+            private int count = 0;
+            private boolean done = false;
+
+            @Override
+            public boolean hasNext() {
+                if (index < count) {
+                    return true;
+                }
+                if (done) {
+                    return false;
+                }
+                try {
+                    count = nextChunkInternal(context.ptr, iter.ptr, next.ptr, chunk);
+                } catch (RuntimeException e) {
+                    // A throwing next() ends the iteration without return()
+                    count = 0;
+                    finish();
+                    throw e;
+                }
+                for (int i = 0; i < count; i++) {
+                    values[i] = new JSValue(chunk[i], context);
+                }
+                index = 0;
+                if (count < chunk.length) {
+                    finish();
+                }
+                return count > 0;
+            }
+
+            @Override
+            public JSValue next() {
+                if (!hasNext()) {
+                    throw new java.util.NoSuchElementException();
+                }
+                JSValue value = values[index];
+                values[index++] = null;
+                return value;
+            }
+
+            @Override
+            public void close() {
+                while (index < count) {
+                    values[index].close();
+                    values[index++] = null;
+                }
+                if (done) {
+                    return;
+                }
+                try {
+                    checkThread();
+                    returnIteratorInternal(context.ptr, iter.ptr);
+                } finally {
+                    finish();
+                }
+            }
+
+            private void finish() {
+                done = true;
+                iter.close();
+                next.close();
+            }
+        };
+    }
+
+    static final int ITERATOR_CHUNK_SIZE = 64;
+
+    private JSIterator arrayLikeIterator() {
         int length = getLength();
-        // If undefined, getLength returns?
-        // We implemented getLength to return asInteger() of "length" property.
-        // If undefined, asInteger -> 0 (usually, depending on implementation).
 
-        return new java.util.Iterator<JSValue>() {
+        return new JSIterator() {
             private int index = 0;
 
             @Override
@@ -334,22 +534,29 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
                 }
                 return getProperty(index++);
             }
+
+            @Override
+            public void close() {
+                // Nothing is held between calls
+            }
         };
     }
 
-    private static class NativeValueCleaner implements Runnable {
-        private final long valPtr;
-        private final long ctxPtr;
-
-        NativeValueCleaner(long valPtr, long ctxPtr) {
-            this.valPtr = valPtr;
-            this.ctxPtr = ctxPtr;
-        }
-
-        @Override
-        public void run() {
-            closeInternal(ctxPtr, valPtr);
+    /**
+     * Own enumerable string-keyed properties and their values, in property
+     * order, read in a single native call. The caller owns the values.
+     */
+    public java.util.Map<String, JSValue> entries() {
+        checkThread();
+        checkClosed();
+        Object[] result = entriesInternal(context.ptr, ptr);
+        String[] keys = (String[]) result[0];
+        long[] values = (long[]) result[1];
+        java.util.Map<String, JSValue> entries = new java.util.LinkedHashMap<>(keys.length * 2);
+        for (int i = 0; i < keys.length; i++) {
+            entries.put(keys[i], new JSValue(values[i], context));
         }
+        return entries;
     }
 
     private native int toIntegerInternal(long contextPtr, long valPtr);
@@ -362,6 +569,12 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
 
     private native String toJSONInternal(long contextPtr, long valPtr);
 
+    private native byte[] serializeInternal(long contextPtr, long valPtr);
+
+    private native long writeMessageInternal(long contextPtr, long valPtr);
+
+    private native String describeErrorInternal(long contextPtr, long valPtr);
+
     private native int getTagInternal(long contextPtr, long valPtr);
 
     private native long getPropertyStrInternal(long contextPtr, long valPtr, String key);
@@ -374,11 +587,21 @@ public class JSValue implements AutoCloseable, Iterable<JSValue> {
 
     private native boolean hasPropertyInternal(long contextPtr, long valPtr, String key);
 
-    private native long callInternal(long contextPtr, long funcPtr, long thisPtr, long[] args);
+    private native long callInternal(long contextPtr, long funcPtr, long thisPtr, long[] args, long timeoutMicros,
+            long interruptBudget);
+
+    private native String functionNameInternal(long contextPtr, long funcPtr);
 
     private native String[] getKeysInternal(long contextPtr, long valPtr);
 
-    private static native void closeInternal(long contextPtr, long valPtr);
+    private native Object[] entriesInternal(long contextPtr, long valPtr);
+
+    private native long iteratorInternal(long contextPtr, long valPtr, long[] nextOut);
+
+    private native int nextChunkInternal(long contextPtr, long iterPtr, long nextPtr, long[] out);
+
+    private native void returnIteratorInternal(long contextPtr, long iterPtr);
+
 
     private native long dupInternal(long contextPtr, long valPtr);
 
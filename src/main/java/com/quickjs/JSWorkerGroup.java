@@ -0,0 +1,269 @@
+package com.quickjs;
+
+import java.time.Duration;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * A fixed number of runtimes, each running on its own thread, that share
+ * {@code SharedArrayBuffer} memory and talk to each other through messages.
+ *
+ * <p>
+ * Every worker evaluates the same script with these globals defined:
+ * <ul>
+ * <li>{@code workerId} and {@code workerCount}</li>
+ * <li>{@code postMessage(target, value)}, which sends {@code value} to worker
+ * {@code target}, or to the host when {@code target} is {@link #HOST}</li>
+ * <li>{@code onmessage}, which the script may set to a
+ * {@code (value, from) => ...} handler</li>
+ * </ul>
+ * Messages are serialized as by {@link JSValue#serialize()}, except that a
+ * {@code SharedArrayBuffer} is passed by reference, so workers can split work
+ * over the same memory and coordinate with {@code Atomics.wait} and
+ * {@code Atomics.notify}.
+ *
+ * <p>
+ * An uncaught error in a worker is rethrown by {@link #receive} on the host.
+ */
+public final class JSWorkerGroup implements AutoCloseable {
+
+    /** Message target and sender id of the host. */
+    public static final int HOST = -1;
+
+    private static final Object SHUTDOWN = new Object();
+
+    private final Worker[] workers;
+    private final String script;
+    private final String fileName;
+    private final BlockingQueue<Object> hostInbox = new LinkedBlockingQueue<>();
+    private volatile boolean closed = false;
+
+    private JSWorkerGroup(int size, String script, String fileName) {
+        this.script = script;
+        this.fileName = fileName;
+        this.workers = new Worker[size];
+        for (int i = 0; i < size; i++) {
+            workers[i] = new Worker(i);
+        }
+        for (Worker worker : workers) {
+            worker.thread.start();
+        }
+    }
+
+    public static JSWorkerGroup start(int size, String script) {
+        return start(size, script, "<worker>");
+    }
+
+    public static JSWorkerGroup start(int size, String script, String fileName) {
+        if (size <= 0) {
+            throw new IllegalArgumentException("size must be positive");
+        }
+        return new JSWorkerGroup(size, script, fileName);
+    }
+
+    public int size() {
+        return workers.length;
+    }
+
+    /**
+     * Send a value to a worker. Must be called on the thread that owns the
+     * value's runtime.
+     */
+    public void postMessage(int worker, JSValue value) {
+        send(HOST, worker, value);
+    }
+
+    /**
+     * Wait for the next message a worker sent to {@link #HOST} and read it into
+     * {@code context}.
+     */
+    public JSValue receive(JSContext context) throws InterruptedException {
+        return read(context, hostInbox.take());
+    }
+
+    /** As {@link #receive(JSContext)}, returning null if nothing arrives in time. */
+    public JSValue receive(JSContext context, Duration timeout) throws InterruptedException {
+        Object item = hostInbox.poll(timeout.toNanos(), TimeUnit.NANOSECONDS);
+        return item == null ? null : read(context, item);
+    }
+
+    /**
+     * Stop all workers and wait for their threads to exit. A script busy in JS
+     * is interrupted, but one blocked in {@code Atomics.wait} must be woken by
+     * {@code Atomics.notify} first.
+     */
+    @Override
+    public void close() {
+        if (closed) {
+            return;
+        }
+        closed = true;
+        for (Worker worker : workers) {
+            worker.stop();
+        }
+        boolean interrupted = false;
+        for (Worker worker : workers) {
+            while (worker.thread.isAlive()) {
+                try {
+                    worker.thread.join();
+                } catch (InterruptedException e) {
+                    interrupted = true;
+                }
+            }
+        }
+        // A worker may have posted to one that had already drained its inbox
+        // and exited; nothing can send once every thread is gone.
+        for (Worker worker : workers) {
+            drain(worker.inbox);
+        }
+        drain(hostInbox);
+        if (interrupted) {
+            Thread.currentThread().interrupt();
+        }
+    }
+
+    private void send(int from, int to, JSValue value) {
+        if (closed) {
+            throw new IllegalStateException("JSWorkerGroup is closed");
+        }
+        BlockingQueue<Object> inbox;
+        if (to == HOST) {
+            inbox = hostInbox;
+        } else if (to >= 0 && to < workers.length) {
+            inbox = workers[to].inbox;
+        } else {
+            throw new IllegalArgumentException("No such worker: " + to);
+        }
+        inbox.add(new Message(from, value.writeMessage()));
+    }
+
+    private static JSValue read(JSContext context, Object item) {
+        if (item instanceof RuntimeException) {
+            throw (RuntimeException) item;
+        }
+        Message message = (Message) item;
+        try {
+            return context.readMessage(message.ptr);
+        } finally {
+            freeMessageInternal(message.ptr);
+        }
+    }
+
+    private static void drain(BlockingQueue<Object> inbox) {
+        Object item;
+        while ((item = inbox.poll()) != null) {
+            if (item instanceof Message) {
+                freeMessageInternal(((Message) item).ptr);
+            }
+        }
+    }
+
+    private static final class Message {
+        final int from;
+        final long ptr;
+
+        Message(int from, long ptr) {
+            this.from = from;
+            this.ptr = ptr;
+        }
+    }
+
+    private final class Worker {
+        final int id;
+        final Thread thread;
+        final BlockingQueue<Object> inbox = new LinkedBlockingQueue<>();
+        private volatile JSRuntime runtime;
+
+        Worker(int id) {
+            this.id = id;
+            this.thread = new Thread(this::run, "quickjs-worker-" + id);
+            this.thread.setDaemon(true);
+        }
+
+        void stop() {
+            inbox.add(SHUTDOWN);
+            JSRuntime rt = runtime;
+            if (rt != null) {
+                rt.interrupt();
+            }
+        }
+
+        private void run() {
+            try (JSRuntime rt = QuickJS.createRuntime();
+                    JSContext context = rt.createContext()) {
+                rt.setCanBlock(true);
+                runtime = rt;
+                if (closed) {
+                    return;
+                }
+                installGlobals(context);
+                try {
+                    context.eval(script, fileName, JSContext.EVAL_TYPE_GLOBAL).close();
+                    rt.runEventLoop();
+                } catch (RuntimeException e) {
+                    report(e);
+                    return;
+                }
+                dispatchMessages(rt, context);
+            } catch (InterruptedException e) {
+                // Closed while waiting for a message
+            } catch (RuntimeException e) {
+                report(e);
+            } finally {
+                runtime = null;
+                drain(inbox);
+            }
+        }
+
+        private void installGlobals(JSContext context) {
+            try (JSValue value = context.createInteger(id)) {
+                context.setGlobal("workerId", value);
+            }
+            try (JSValue value = context.createInteger(workers.length)) {
+                context.setGlobal("workerCount", value);
+            }
+            JSFunction post = (ctx, thisObj, args) -> {
+                if (args.length < 2) {
+                    throw new IllegalArgumentException("postMessage(target, value) expects 2 arguments");
+                }
+                send(id, args[0].asInteger(), args[1]);
+                return null;
+            };
+            try (JSValue value = context.createFunction(post, "postMessage", 2)) {
+                context.setGlobal("postMessage", value);
+            }
+        }
+
+        private void dispatchMessages(JSRuntime rt, JSContext context) throws InterruptedException {
+            Object item;
+            while ((item = inbox.take()) != SHUTDOWN) {
+                Message message = (Message) item;
+                try (JSValue value = read(context, message);
+                        JSValue from = context.createInteger(message.from);
+                        JSValue global = context.getGlobalObject();
+                        JSValue handler = global.getProperty("onmessage")) {
+                    if (handler.isFunction()) {
+                        handler.call(null, value, from).close();
+                    }
+                    rt.runEventLoop();
+                } catch (RuntimeException e) {
+                    if (closed) {
+                        return;
+                    }
+                    report(e);
+                }
+            }
+        }
+
+        private void report(RuntimeException e) {
+            // Format a JS exception's message while still on its runtime thread
+            e.getMessage();
+            if (!closed) {
+                hostInbox.add(e);
+            }
+        }
+    }
+
+    private static native void freeMessageInternal(long messagePtr);
+}
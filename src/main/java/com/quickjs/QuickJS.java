@@ -1,11 +1,23 @@
 package com.quickjs;
 
-import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.file.AtomicMoveNotSupportedException;
+import java.nio.file.FileAlreadyExistsException;
 import java.nio.file.Files;
+import java.nio.file.LinkOption;
+import java.nio.file.Path;
+import java.nio.file.Paths;
 import java.nio.file.StandardCopyOption;
+import java.nio.file.attribute.PosixFileAttributes;
+import java.nio.file.attribute.PosixFilePermission;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.nio.file.attribute.UserPrincipal;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
 import java.lang.ref.Cleaner;
+import java.util.EnumSet;
+import java.util.Set;
 
 public class QuickJS {
 
@@ -34,7 +46,7 @@ public class QuickJS {
     public static class Builder {
         private long memoryLimit = -1;
         private long maxStackSize = -1;
-        private boolean withStdLib = true;
+        private EnumSet<JSIntrinsic> intrinsics = EnumSet.allOf(JSIntrinsic.class);
 
         public Builder withMemoryLimit(long memoryLimit) {
             this.memoryLimit = memoryLimit;
@@ -46,8 +58,18 @@ public class QuickJS {
             return this;
         }
 
+        /** Create contexts with only the base objects and {@code eval}. */
         public Builder withoutStdLib() {
-            this.withStdLib = false;
+            return withIntrinsics(EnumSet.of(JSIntrinsic.EVAL));
+        }
+
+        /**
+         * Create contexts with the base objects plus {@code intrinsics}, unless
+         * {@link JSRuntime#createContext(Set)} asks for others. All of them by
+         * default.
+         */
+        public Builder withIntrinsics(Set<JSIntrinsic> intrinsics) {
+            this.intrinsics = intrinsics.isEmpty() ? EnumSet.noneOf(JSIntrinsic.class) : EnumSet.copyOf(intrinsics);
             return this;
         }
 
@@ -64,31 +86,96 @@ public class QuickJS {
                 runtime.setMaxStackSize(maxStackSize);
             }
 
-            runtime.setWithStdLib(withStdLib);
+            runtime.setDefaultIntrinsics(intrinsics);
             return runtime;
         }
     }
 
+    // Extracts the bundled library once per version and content into
+    // <quickjs.native.cacheDir or java.io.tmpdir/quickjs-jni-<user>>/<version>-<sha256>/
+    // and loads it from there on every later start.
     private static void loadNativeLibraryFromJar() throws IOException {
         String libName = System.mapLibraryName("quickjs-jni");
+        byte[] library;
         try (InputStream is = QuickJS.class.getClassLoader().getResourceAsStream(libName)) {
             if (is == null) {
                 throw new IOException("Native library not found in JAR: " + libName);
             }
-            File tempLib = File.createTempFile("quickjs-jni", "." + getLibExtension());
-            tempLib.deleteOnExit();
-            Files.copy(is, tempLib.toPath(), StandardCopyOption.REPLACE_EXISTING);
-            System.load(tempLib.getAbsolutePath());
+            library = is.readAllBytes();
+        }
+        byte[] digest = sha256(library);
+        String version = QuickJS.class.getPackage().getImplementationVersion();
+        Path dir = nativeCacheRoot().resolve((version != null ? version : "dev") + "-" + hex(digest, 16));
+        createPrivateDirectories(dir);
+        Path target = dir.resolve(libName);
+        // Only load a cached file with exactly the jar's content; anything
+        // else is a partial write or was planted, and is replaced
+        if (!Files.isRegularFile(target, LinkOption.NOFOLLOW_LINKS)
+                || !MessageDigest.isEqual(digest, sha256(Files.readAllBytes(target)))) {
+            // Write aside and rename, so concurrent JVMs never load a partial file
+            Path partial = Files.createTempFile(dir, libName, ".tmp");
+            try {
+                Files.write(partial, library);
+                try {
+                    Files.move(partial, target, StandardCopyOption.ATOMIC_MOVE);
+                } catch (AtomicMoveNotSupportedException | FileAlreadyExistsException e) {
+                    Files.move(partial, target, StandardCopyOption.REPLACE_EXISTING);
+                }
+            } finally {
+                Files.deleteIfExists(partial);
+            }
+        }
+        System.load(target.toAbsolutePath().toString());
+    }
+
+    private static Path nativeCacheRoot() {
+        String dir = System.getProperty("quickjs.native.cacheDir");
+        if (dir != null) {
+            return Paths.get(dir);
+        }
+        // Per user, so users of a shared tmpdir never load each other's files
+        String user = System.getProperty("user.name", "").replaceAll("[^A-Za-z0-9._-]", "_");
+        return Paths.get(System.getProperty("java.io.tmpdir"), "quickjs-jni-" + user);
+    }
+
+    // Create dir and its cache root owner-only, and refuse to use them if
+    // another user owns them or can write to them: whoever can write there
+    // could swap the library between our check and System.load.
+    private static void createPrivateDirectories(Path dir) throws IOException {
+        if (!dir.getFileSystem().supportedFileAttributeViews().contains("posix")) {
+            Files.createDirectories(dir);
+            return;
+        }
+        Files.createDirectories(dir,
+                PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString("rwx------")));
+        UserPrincipal user = dir.getFileSystem().getUserPrincipalLookupService()
+                .lookupPrincipalByName(System.getProperty("user.name"));
+        for (Path path : new Path[] { dir.getParent(), dir }) {
+            PosixFileAttributes attrs = Files.readAttributes(path, PosixFileAttributes.class,
+                    LinkOption.NOFOLLOW_LINKS);
+            Set<PosixFilePermission> perms = attrs.permissions();
+            if (!attrs.isDirectory() || !attrs.owner().equals(user)
+                    || perms.contains(PosixFilePermission.GROUP_WRITE)
+                    || perms.contains(PosixFilePermission.OTHERS_WRITE)) {
+                throw new IOException("Native library cache " + path + " is not private to " + user.getName());
+            }
         }
     }
 
-    private static String getLibExtension() {
-        String os = System.getProperty("os.name").toLowerCase();
-        if (os.contains("win"))
-            return "dll";
-        if (os.contains("mac"))
-            return "dylib";
-        return "so";
+    private static byte[] sha256(byte[] data) {
+        try {
+            return MessageDigest.getInstance("SHA-256").digest(data);
+        } catch (NoSuchAlgorithmException e) {
+            throw new IllegalStateException("SHA-256 is not available", e);
+        }
+    }
+
+    private static String hex(byte[] bytes, int length) {
+        StringBuilder sb = new StringBuilder();
+        for (int i = 0; i < length; i++) {
+            sb.append(String.format("%02x", bytes[i]));
+        }
+        return sb.toString();
     }
 
     private static native long createNativeRuntime();
@@ -1,7 +1,44 @@
 package com.quickjs;
 
 public class QuickJSException extends RuntimeException {
+    // The thrown JS value, held until the message is first needed
+    private JSValue error;
+    private String message;
+
     public QuickJSException(String message) {
         super(message);
+        this.message = message;
+    }
+
+    /**
+     * Created by the native layer for a JS exception. Formatting the message
+     * and stack is deferred, so scripts that throw as control flow only pay
+     * for it when the message is read.
+     */
+    QuickJSException(JSValue error) {
+        super((String) null);
+        this.error = error;
+        error.trackException(this);
+    }
+
+    /**
+     * The JS error's string form followed by its stack. It is formatted on
+     * first call, which must happen on the runtime's thread; elsewhere a
+     * placeholder is returned until then. Exceptions still pending when their
+     * context closes are formatted at that point.
+     */
+    @Override
+    public String getMessage() {
+        materialize();
+        return message != null ? message
+                : getClass().getSimpleName() + " (message is only available on the JS runtime thread)";
+    }
+
+    synchronized void materialize() {
+        if (error != null && error.isOwnerThread()) {
+            message = error.describeError();
+            error.close();
+            error = null;
+        }
     }
 }
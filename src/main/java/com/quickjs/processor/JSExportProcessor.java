@@ -0,0 +1,235 @@
+package com.quickjs.processor;
+
+import com.quickjs.JSExport;
+
+import javax.annotation.processing.AbstractProcessor;
+import javax.annotation.processing.RoundEnvironment;
+import javax.annotation.processing.SupportedAnnotationTypes;
+import javax.lang.model.SourceVersion;
+import javax.lang.model.element.Element;
+import javax.lang.model.element.ElementKind;
+import javax.lang.model.element.ExecutableElement;
+import javax.lang.model.element.Modifier;
+import javax.lang.model.element.PackageElement;
+import javax.lang.model.element.TypeElement;
+import javax.lang.model.element.VariableElement;
+import javax.lang.model.type.TypeMirror;
+import javax.tools.Diagnostic;
+import java.io.IOException;
+import java.io.PrintWriter;
+import java.io.Writer;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * Generates a {@code com.quickjs.JSClassBinding} for every class annotated with
+ * {@link JSExport}. Add this library to the {@code annotationProcessor} path to
+ * enable it.
+ */
+@SupportedAnnotationTypes("com.quickjs.JSExport")
+public final class JSExportProcessor extends AbstractProcessor {
+
+    private static final class Member {
+        final String jsName;
+        final String javaName;
+        final String signature;
+        final boolean getter;
+
+        Member(String jsName, String javaName, String signature, boolean getter) {
+            this.jsName = jsName;
+            this.javaName = javaName;
+            this.signature = signature;
+            this.getter = getter;
+        }
+    }
+
+    @Override
+    public SourceVersion getSupportedSourceVersion() {
+        return SourceVersion.latestSupported();
+    }
+
+    @Override
+    public boolean process(Set<? extends TypeElement> annotations, RoundEnvironment roundEnv) {
+        for (Element element : roundEnv.getElementsAnnotatedWith(JSExport.class)) {
+            ElementKind kind = element.getKind();
+            if (kind == ElementKind.CLASS) {
+                generate((TypeElement) element);
+            } else if (kind.isClass() || kind.isInterface()) {
+                // Enums, records, interfaces and annotation types
+                error(element, "@JSExport can only be placed on classes, not on "
+                        + kind.name().toLowerCase(Locale.ROOT).replace('_', ' ') + "s");
+            } else if (kind == ElementKind.METHOD
+                    && element.getEnclosingElement().getAnnotation(JSExport.class) == null) {
+                error(element, "@JSExport methods must be declared in a @JSExport class");
+            }
+        }
+        return true;
+    }
+
+    private void generate(TypeElement type) {
+        List<Member> members = new ArrayList<>();
+        Map<String, Element> names = new HashMap<>();
+        boolean valid = true;
+        for (Element enclosed : type.getEnclosedElements()) {
+            JSExport export = enclosed.getAnnotation(JSExport.class);
+            if (export == null || enclosed.getKind() != ElementKind.METHOD) {
+                continue;
+            }
+            Member member = toMember((ExecutableElement) enclosed, export);
+            if (member == null) {
+                valid = false;
+                continue;
+            }
+            Element previous = names.putIfAbsent(member.jsName, enclosed);
+            if (previous != null) {
+                error(enclosed, "Duplicate @JSExport name \"" + member.jsName + "\" in " + type.getQualifiedName()
+                        + ", also used by " + previous.getSimpleName() + "()");
+                valid = false;
+                continue;
+            }
+            members.add(member);
+        }
+        if (!valid) {
+            // The errors fail the build; do not add a binding that would not match
+            return;
+        }
+
+        PackageElement pkg = processingEnv.getElementUtils().getPackageOf(type);
+        String packageName = pkg.isUnnamed() ? "" : pkg.getQualifiedName().toString();
+        String binaryName = processingEnv.getElementUtils().getBinaryName(type).toString();
+        String simpleBinaryName = packageName.isEmpty() ? binaryName : binaryName.substring(packageName.length() + 1);
+        String bindingName = simpleBinaryName.replace('$', '_') + "_JSBinding";
+        String jsClassName = type.getAnnotation(JSExport.class).value();
+        if (jsClassName.isEmpty()) {
+            jsClassName = type.getSimpleName().toString();
+        }
+
+        String qualifiedName = packageName.isEmpty() ? bindingName : packageName + "." + bindingName;
+        try (Writer writer = processingEnv.getFiler().createSourceFile(qualifiedName, type).openWriter();
+                PrintWriter out = new PrintWriter(writer)) {
+            if (!packageName.isEmpty()) {
+                out.println("package " + packageName + ";");
+                out.println();
+            }
+            out.println("// Generated by " + JSExportProcessor.class.getName() + ". Do not edit.");
+            out.println("public final class " + bindingName + " extends com.quickjs.JSClassBinding {");
+            out.println("    public " + bindingName + "() {");
+            out.println("        super(" + type.getQualifiedName() + ".class, " + quote(jsClassName) + ",");
+            out.println("                new String[] { " + join(members, 0) + " },");
+            out.println("                new String[] { " + join(members, 1) + " },");
+            out.println("                new String[] { " + join(members, 2) + " },");
+            out.println("                new boolean[] { " + join(members, 3) + " });");
+            out.println("    }");
+            out.println("}");
+        } catch (IOException e) {
+            error(type, "Failed to write " + qualifiedName + ": " + e.getMessage());
+        }
+    }
+
+    private Member toMember(ExecutableElement method, JSExport export) {
+        Set<Modifier> modifiers = method.getModifiers();
+        if (!modifiers.contains(Modifier.PUBLIC) || modifiers.contains(Modifier.STATIC)) {
+            error(method, "@JSExport methods must be public instance methods");
+            return null;
+        }
+
+        StringBuilder signature = new StringBuilder("(");
+        for (VariableElement param : method.getParameters()) {
+            String descriptor = descriptor(param.asType(), false);
+            if (descriptor == null) {
+                error(param, "Unsupported @JSExport parameter type " + param.asType());
+                return null;
+            }
+            signature.append(descriptor);
+        }
+        String ret = descriptor(method.getReturnType(), true);
+        if (ret == null) {
+            error(method, "Unsupported @JSExport return type " + method.getReturnType());
+            return null;
+        }
+        signature.append(')').append(ret);
+
+        String javaName = method.getSimpleName().toString();
+        String jsName = export.value();
+        if (export.getter()) {
+            if (!method.getParameters().isEmpty() || ret.equals("V")) {
+                error(method, "@JSExport getters must take no arguments and return a value");
+                return null;
+            }
+            if (jsName.isEmpty()) {
+                jsName = propertyName(javaName);
+            }
+        } else if (jsName.isEmpty()) {
+            jsName = javaName;
+        }
+        return new Member(jsName, javaName, signature.toString(), export.getter());
+    }
+
+    private static String descriptor(TypeMirror type, boolean isReturn) {
+        switch (type.getKind()) {
+            case BOOLEAN:
+                return "Z";
+            case INT:
+                return "I";
+            case LONG:
+                return "J";
+            case FLOAT:
+                return "F";
+            case DOUBLE:
+                return "D";
+            case VOID:
+                return isReturn ? "V" : null;
+            case DECLARED:
+                return type.toString().equals("java.lang.String") ? "Ljava/lang/String;" : null;
+            default:
+                return null;
+        }
+    }
+
+    private static String propertyName(String javaName) {
+        String name = javaName;
+        if (name.startsWith("get") && name.length() > 3) {
+            name = name.substring(3);
+        } else if (name.startsWith("is") && name.length() > 2) {
+            name = name.substring(2);
+        } else {
+            return name;
+        }
+        return Character.toLowerCase(name.charAt(0)) + name.substring(1);
+    }
+
+    private static String join(List<Member> members, int column) {
+        StringBuilder sb = new StringBuilder();
+        for (Member m : members) {
+            if (sb.length() > 0) {
+                sb.append(", ");
+            }
+            switch (column) {
+                case 0:
+                    sb.append(quote(m.jsName));
+                    break;
+                case 1:
+                    sb.append(quote(m.javaName));
+                    break;
+                case 2:
+                    sb.append(quote(m.signature));
+                    break;
+                default:
+                    sb.append(m.getter);
+            }
+        }
+        return sb.toString();
+    }
+
+    private static String quote(String s) {
+        return '"' + s.replace("\\", "\\\\").replace("\"", "\\\"") + '"';
+    }
+
+    private void error(Element element, String message) {
+        processingEnv.getMessager().printMessage(Diagnostic.Kind.ERROR, message, element);
+    }
+}
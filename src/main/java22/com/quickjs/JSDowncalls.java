@@ -0,0 +1,147 @@
+package com.quickjs;
+
+import java.lang.foreign.FunctionDescriptor;
+import java.lang.foreign.Linker;
+import java.lang.foreign.SymbolLookup;
+import java.lang.invoke.MethodHandle;
+
+import static java.lang.foreign.ValueLayout.JAVA_DOUBLE;
+import static java.lang.foreign.ValueLayout.JAVA_INT;
+import static java.lang.foreign.ValueLayout.JAVA_LONG;
+
+/**
+ * JDK 22+ version of the Java 11 class of the same name: binds the
+ * {@code quickjs_ffm_*} functions of the native library as FFM downcalls.
+ * Everything except {@link #freeValue} is linked critical, skipping the
+ * thread state transition, since those functions neither allocate nor call
+ * back into the JVM. If the functions cannot be bound (native access denied,
+ * or an older native library), {@link #ENABLED} is false and callers fall
+ * back to JNI.
+ */
+final class JSDowncalls {
+    // Value tags, as returned by JSValue.getTypeTag()
+    static final int TAG_STRING = -7;
+    static final int TAG_OBJECT = -1;
+    static final int TAG_INT = 0;
+    static final int TAG_BOOL = 1;
+    static final int TAG_NULL = 2;
+    static final int TAG_UNDEFINED = 3;
+    static final int TAG_FLOAT64 = 8;
+
+    static final boolean ENABLED;
+
+    private static final MethodHandle TAG;
+    private static final MethodHandle GET_INT;
+    private static final MethodHandle GET_FLOAT64;
+    private static final MethodHandle IS_ARRAY;
+    private static final MethodHandle IS_FUNCTION;
+    private static final MethodHandle IS_ERROR;
+    private static final MethodHandle FREE_VALUE;
+
+    static {
+        MethodHandle tag = null;
+        MethodHandle getInt = null;
+        MethodHandle getFloat64 = null;
+        MethodHandle isArray = null;
+        MethodHandle isFunction = null;
+        MethodHandle isError = null;
+        MethodHandle freeValue = null;
+        boolean enabled = false;
+        try {
+            // Only reached through a JSValue, so QuickJS has loaded the library
+            // into this class loader already
+            Linker linker = Linker.nativeLinker();
+            SymbolLookup lookup = SymbolLookup.loaderLookup();
+            Linker.Option critical = Linker.Option.critical(false);
+            tag = bind(linker, lookup, "quickjs_ffm_tag", FunctionDescriptor.of(JAVA_INT, JAVA_LONG), critical);
+            getInt = bind(linker, lookup, "quickjs_ffm_get_int", FunctionDescriptor.of(JAVA_INT, JAVA_LONG),
+                    critical);
+            getFloat64 = bind(linker, lookup, "quickjs_ffm_get_float64",
+                    FunctionDescriptor.of(JAVA_DOUBLE, JAVA_LONG), critical);
+            isArray = bind(linker, lookup, "quickjs_ffm_is_array", FunctionDescriptor.of(JAVA_INT, JAVA_LONG),
+                    critical);
+            isFunction = bind(linker, lookup, "quickjs_ffm_is_function",
+                    FunctionDescriptor.of(JAVA_INT, JAVA_LONG, JAVA_LONG), critical);
+            isError = bind(linker, lookup, "quickjs_ffm_is_error", FunctionDescriptor.of(JAVA_INT, JAVA_LONG),
+                    critical);
+            // Not critical: freeing may run finalizers that use JNI
+            freeValue = bind(linker, lookup, "quickjs_ffm_free_value",
+                    FunctionDescriptor.ofVoid(JAVA_LONG, JAVA_LONG));
+            enabled = true;
+        } catch (RuntimeException | LinkageError e) {
+            // Keep using JNI
+        }
+        TAG = tag;
+        GET_INT = getInt;
+        GET_FLOAT64 = getFloat64;
+        IS_ARRAY = isArray;
+        IS_FUNCTION = isFunction;
+        IS_ERROR = isError;
+        FREE_VALUE = freeValue;
+        ENABLED = enabled;
+    }
+
+    private JSDowncalls() {
+    }
+
+    private static MethodHandle bind(Linker linker, SymbolLookup lookup, String name, FunctionDescriptor descriptor,
+            Linker.Option... options) {
+        return linker.downcallHandle(lookup.find(name).orElseThrow(), descriptor, options);
+    }
+
+    static int tag(long valPtr) {
+        try {
+            return (int) TAG.invokeExact(valPtr);
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static int getInt(long valPtr) {
+        try {
+            return (int) GET_INT.invokeExact(valPtr);
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static double getFloat64(long valPtr) {
+        try {
+            return (double) GET_FLOAT64.invokeExact(valPtr);
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static boolean isArray(long valPtr) {
+        try {
+            return (int) IS_ARRAY.invokeExact(valPtr) != 0;
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static boolean isFunction(long contextPtr, long valPtr) {
+        try {
+            return (int) IS_FUNCTION.invokeExact(contextPtr, valPtr) != 0;
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static boolean isError(long valPtr) {
+        try {
+            return (int) IS_ERROR.invokeExact(valPtr) != 0;
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+
+    static void freeValue(long runtimePtr, long valPtr) {
+        try {
+            FREE_VALUE.invokeExact(runtimePtr, valPtr);
+        } catch (Throwable t) {
+            throw new AssertionError(t);
+        }
+    }
+}
@@ -1,7 +1,18 @@
 #include "quickjs.h"
 #include <jni.h>
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
 
 static JavaVM *g_vm;
 static JSClassID js_java_proxy_class_id;
@@ -35,6 +46,80 @@ static jclass g_JSReferenceErrorClass;
 static jclass g_JSTypeErrorClass;
 static jclass g_JSRangeErrorClass;
 static jclass g_JSInternalErrorClass;
+static jclass g_JSTimeoutExceptionClass;
+
+// Cached java.* classes and methods
+static jclass g_ObjectClass;
+static jmethodID g_Object_toString;
+static jclass g_StringClass;
+static jclass g_BooleanClass;
+static jmethodID g_Boolean_valueOf;
+static jmethodID g_Boolean_booleanValue;
+static jclass g_IntegerClass;
+static jmethodID g_Integer_valueOf;
+static jclass g_LongClass;
+static jclass g_DoubleClass;
+static jmethodID g_Double_valueOf;
+static jclass g_NumberClass;
+static jmethodID g_Number_intValue;
+static jmethodID g_Number_longValue;
+static jmethodID g_Number_doubleValue;
+static jclass g_CollectionClass;
+static jmethodID g_Collection_toArray;
+static jclass g_MapClass;
+static jmethodID g_Map_get;
+static jmethodID g_Map_containsKey;
+static jmethodID g_Map_put;
+static jmethodID g_Map_remove;
+static jmethodID g_Map_keySet;
+static jclass g_ListClass;
+static jclass g_JSMetricsClass;
+static jmethodID g_JSMetrics_record;
+static jmethodID g_List_get;
+static jmethodID g_List_set;
+static jmethodID g_List_add;
+static jmethodID g_List_size;
+
+// Java exception classes by JS error name, with their constructors taking the
+// thrown JS value. The last entry is the fallback for any other value.
+typedef struct {
+  const char *name;
+  jclass *cls;
+  jmethodID lazy_ctor;
+} ErrorClassMapping;
+
+static ErrorClassMapping g_errorClasses[] = {
+    {"SyntaxError", &g_JSSyntaxErrorClass, NULL},
+    {"ReferenceError", &g_JSReferenceErrorClass, NULL},
+    {"TypeError", &g_JSTypeErrorClass, NULL},
+    {"RangeError", &g_JSRangeErrorClass, NULL},
+    {"InternalError", &g_JSInternalErrorClass, NULL},
+    {NULL, &g_QuickJSExceptionClass, NULL},
+};
+
+// Every cached global class reference, released on unload
+static jclass *const g_cachedClasses[] = {
+    &g_JSFunctionClass,        &g_JSValueClass,
+    &g_QuickJSExceptionClass,  &g_JSSyntaxErrorClass,
+    &g_JSReferenceErrorClass,  &g_JSTypeErrorClass,
+    &g_JSRangeErrorClass,      &g_JSInternalErrorClass,
+    &g_JSTimeoutExceptionClass, &g_ObjectClass,
+    &g_StringClass,            &g_BooleanClass,
+    &g_IntegerClass,           &g_LongClass,
+    &g_DoubleClass,            &g_NumberClass,
+    &g_CollectionClass,        &g_MapClass,
+    &g_ListClass,              &g_JSMetricsClass,
+};
+
+static void release_cached_classes(JNIEnv *env) {
+  for (size_t i = 0; i < sizeof(g_cachedClasses) / sizeof(g_cachedClasses[0]);
+       i++) {
+    if (*g_cachedClasses[i]) {
+      (*env)->DeleteGlobalRef(env, *g_cachedClasses[i]);
+      *g_cachedClasses[i] = NULL;
+    }
+  }
+}
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
   g_vm = vm;
@@ -80,7 +165,7 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
   // Cache Exception Classes
   jclass localEx;
 
-// Helper macro for caching exceptions
+// Helper macro for caching classes
 #define CACHE_EX(clsName, globalVar)                                           \
   localEx = (*env)->FindClass(env, clsName);                                   \
   if (!localEx)                                                                \
@@ -90,36 +175,83 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
   if (!globalVar)                                                              \
     goto error;
 
+#define CACHE_METHOD(globalVar, cls, name, sig)                                \
+  globalVar = (*env)->GetMethodID(env, cls, name, sig);                        \
+  if (!globalVar)                                                              \
+    goto error;
+
+#define CACHE_STATIC_METHOD(globalVar, cls, name, sig)                         \
+  globalVar = (*env)->GetStaticMethodID(env, cls, name, sig);                  \
+  if (!globalVar)                                                              \
+    goto error;
+
   CACHE_EX("com/quickjs/QuickJSException", g_QuickJSExceptionClass);
   CACHE_EX("com/quickjs/JSSyntaxError", g_JSSyntaxErrorClass);
   CACHE_EX("com/quickjs/JSReferenceError", g_JSReferenceErrorClass);
   CACHE_EX("com/quickjs/JSTypeError", g_JSTypeErrorClass);
   CACHE_EX("com/quickjs/JSRangeError", g_JSRangeErrorClass);
   CACHE_EX("com/quickjs/JSInternalError", g_JSInternalErrorClass);
+  CACHE_EX("com/quickjs/JSTimeoutException", g_JSTimeoutExceptionClass);
+
+  for (size_t i = 0; i < sizeof(g_errorClasses) / sizeof(g_errorClasses[0]);
+       i++) {
+    CACHE_METHOD(g_errorClasses[i].lazy_ctor, *g_errorClasses[i].cls, "<init>",
+                 "(Lcom/quickjs/JSValue;)V");
+  }
+
+  CACHE_EX("com/quickjs/JSMetrics", g_JSMetricsClass);
+  CACHE_METHOD(g_JSMetrics_record, g_JSMetricsClass, "record",
+               "(ILjava/lang/String;Ljava/lang/String;J)V");
+
+  // Cache java.* classes used for value conversion
+  CACHE_EX("java/lang/Object", g_ObjectClass);
+  CACHE_METHOD(g_Object_toString, g_ObjectClass, "toString",
+               "()Ljava/lang/String;");
+  CACHE_EX("java/lang/String", g_StringClass);
+  CACHE_EX("java/lang/Boolean", g_BooleanClass);
+  CACHE_STATIC_METHOD(g_Boolean_valueOf, g_BooleanClass, "valueOf",
+                      "(Z)Ljava/lang/Boolean;");
+  CACHE_METHOD(g_Boolean_booleanValue, g_BooleanClass, "booleanValue", "()Z");
+  CACHE_EX("java/lang/Integer", g_IntegerClass);
+  CACHE_STATIC_METHOD(g_Integer_valueOf, g_IntegerClass, "valueOf",
+                      "(I)Ljava/lang/Integer;");
+  CACHE_EX("java/lang/Long", g_LongClass);
+  CACHE_EX("java/lang/Double", g_DoubleClass);
+  CACHE_STATIC_METHOD(g_Double_valueOf, g_DoubleClass, "valueOf",
+                      "(D)Ljava/lang/Double;");
+  CACHE_EX("java/lang/Number", g_NumberClass);
+  CACHE_METHOD(g_Number_intValue, g_NumberClass, "intValue", "()I");
+  CACHE_METHOD(g_Number_longValue, g_NumberClass, "longValue", "()J");
+  CACHE_METHOD(g_Number_doubleValue, g_NumberClass, "doubleValue", "()D");
+  CACHE_EX("java/util/Collection", g_CollectionClass);
+  CACHE_METHOD(g_Collection_toArray, g_CollectionClass, "toArray",
+               "()[Ljava/lang/Object;");
+  CACHE_EX("java/util/Map", g_MapClass);
+  CACHE_METHOD(g_Map_get, g_MapClass, "get",
+               "(Ljava/lang/Object;)Ljava/lang/Object;");
+  CACHE_METHOD(g_Map_containsKey, g_MapClass, "containsKey",
+               "(Ljava/lang/Object;)Z");
+  CACHE_METHOD(g_Map_put, g_MapClass, "put",
+               "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+  CACHE_METHOD(g_Map_remove, g_MapClass, "remove",
+               "(Ljava/lang/Object;)Ljava/lang/Object;");
+  CACHE_METHOD(g_Map_keySet, g_MapClass, "keySet", "()Ljava/util/Set;");
+  CACHE_EX("java/util/List", g_ListClass);
+  CACHE_METHOD(g_List_get, g_ListClass, "get", "(I)Ljava/lang/Object;");
+  CACHE_METHOD(g_List_set, g_ListClass, "set",
+               "(ILjava/lang/Object;)Ljava/lang/Object;");
+  CACHE_METHOD(g_List_add, g_ListClass, "add", "(Ljava/lang/Object;)Z");
+  CACHE_METHOD(g_List_size, g_ListClass, "size", "()I");
 
 #undef CACHE_EX
+#undef CACHE_METHOD
+#undef CACHE_STATIC_METHOD
 
   return JNI_VERSION_1_6;
 
 error:
   // Cleanup whatever was allocated
-  if (g_JSFunctionClass)
-    (*env)->DeleteGlobalRef(env, g_JSFunctionClass);
-  if (g_JSValueClass)
-    (*env)->DeleteGlobalRef(env, g_JSValueClass);
-  if (g_QuickJSExceptionClass)
-    (*env)->DeleteGlobalRef(env, g_QuickJSExceptionClass);
-  if (g_JSSyntaxErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSSyntaxErrorClass);
-  if (g_JSReferenceErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSReferenceErrorClass);
-  if (g_JSTypeErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSTypeErrorClass);
-  if (g_JSRangeErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSRangeErrorClass);
-  if (g_JSInternalErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSInternalErrorClass);
-
+  release_cached_classes(env);
   return JNI_ERR;
 }
 
@@ -129,22 +261,7 @@ JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved) {
     return;
   }
 
-  if (g_JSFunctionClass)
-    (*env)->DeleteGlobalRef(env, g_JSFunctionClass);
-  if (g_JSValueClass)
-    (*env)->DeleteGlobalRef(env, g_JSValueClass);
-  if (g_QuickJSExceptionClass)
-    (*env)->DeleteGlobalRef(env, g_QuickJSExceptionClass);
-  if (g_JSSyntaxErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSSyntaxErrorClass);
-  if (g_JSReferenceErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSReferenceErrorClass);
-  if (g_JSTypeErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSTypeErrorClass);
-  if (g_JSRangeErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSRangeErrorClass);
-  if (g_JSInternalErrorClass)
-    (*env)->DeleteGlobalRef(env, g_JSInternalErrorClass);
+  release_cached_classes(env);
 }
 
 static const char *GetStringUTFChars(JNIEnv *env, jstring str) {
@@ -175,33 +292,15 @@ static jlong boxJSValue(JSValue v) {
 #define CHECK_CONTEXT(ctx) CHECK_PTR(ctx, 0)
 #define CHECK_RUNTIME(rt) CHECK_PTR(rt, 0)
 
-static void throw_java_exception(JNIEnv *env, JSContext *ctx,
-                                 JSValue exception_val) {
-  // 1. Get exception message
+// Format a thrown JS value as "<toString()>\n<stack>". Returns a malloc'd
+// string, or NULL if the value cannot be converted.
+static char *describe_exception(JSContext *ctx, JSValueConst exception_val) {
   const char *msg = JS_ToCString(ctx, exception_val);
-
-  // 2. Detect Exception Class
-  jclass excCls = g_QuickJSExceptionClass;
-  JSValue nameVal = JS_GetPropertyStr(ctx, exception_val, "name");
-  if (!JS_IsUndefined(nameVal) && !JS_IsNull(nameVal)) {
-    const char *name = JS_ToCString(ctx, nameVal);
-    if (name) {
-      if (strcmp(name, "SyntaxError") == 0)
-        excCls = g_JSSyntaxErrorClass;
-      else if (strcmp(name, "ReferenceError") == 0)
-        excCls = g_JSReferenceErrorClass;
-      else if (strcmp(name, "TypeError") == 0)
-        excCls = g_JSTypeErrorClass;
-      else if (strcmp(name, "RangeError") == 0)
-        excCls = g_JSRangeErrorClass;
-      else if (strcmp(name, "InternalError") == 0)
-        excCls = g_JSInternalErrorClass;
-      JS_FreeCString(ctx, name);
-    }
+  if (!msg) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return NULL;
   }
-  JS_FreeValue(ctx, nameVal);
 
-  // 3. Get Stack
   const char *stack = NULL;
   JSValue stackVal = JS_GetPropertyStr(ctx, exception_val, "stack");
   if (!JS_IsUndefined(stackVal)) {
@@ -209,30 +308,123 @@ static void throw_java_exception(JNIEnv *env, JSContext *ctx,
   }
   JS_FreeValue(ctx, stackVal);
 
-  // 4. Construct Full Message
-  char *full_msg = NULL;
-  if (msg && stack && strlen(stack) > 0) {
-    size_t len = strlen(msg) + strlen(stack) + 2;
-    full_msg = malloc(len);
-    if (full_msg)
-      snprintf(full_msg, len, "%s\n%s", msg, stack);
-  }
-  const char *final_msg = full_msg ? full_msg : (msg ? msg : "Unknown Error");
-
-  // 5. Throw Java Exception
-  if (excCls) {
-    (*env)->ThrowNew(env, excCls, final_msg);
-  } else {
-    (*env)->FatalError(env, "QuickJS JNI: Exception class corrupted");
+  size_t msg_len = strlen(msg);
+  size_t stack_len = stack ? strlen(stack) : 0;
+  char *full_msg = malloc(msg_len + stack_len + 2);
+  if (full_msg) {
+    memcpy(full_msg, msg, msg_len);
+    full_msg[msg_len] = '\0';
+    if (stack_len > 0) {
+      full_msg[msg_len] = '\n';
+      memcpy(full_msg + msg_len + 1, stack, stack_len + 1);
+    }
   }
 
-  // Clean up
-  if (msg)
-    JS_FreeCString(ctx, msg);
+  JS_FreeCString(ctx, msg);
   if (stack)
     JS_FreeCString(ctx, stack);
-  if (full_msg)
-    free(full_msg);
+  return full_msg;
+}
+
+static ErrorClassMapping *error_class_for(JSContext *ctx,
+                                          JSValueConst exception_val) {
+  size_t count = sizeof(g_errorClasses) / sizeof(g_errorClasses[0]);
+  ErrorClassMapping *mapping = &g_errorClasses[count - 1];
+  if (!JS_IsObject(exception_val))
+    return mapping;
+
+  JSValue nameVal = JS_GetPropertyStr(ctx, exception_val, "name");
+  if (JS_IsString(nameVal)) {
+    const char *name = JS_ToCString(ctx, nameVal);
+    if (name) {
+      for (size_t i = 0; i < count - 1; i++) {
+        if (strcmp(name, g_errorClasses[i].name) == 0) {
+          mapping = &g_errorClasses[i];
+          break;
+        }
+      }
+      JS_FreeCString(ctx, name);
+    }
+  } else if (JS_IsException(nameVal)) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  }
+  JS_FreeValue(ctx, nameVal);
+  return mapping;
+}
+
+// The context opaque. The intrinsics are taken before any script runs, so
+// native code keeps using them after scripts replace or redefine the globals.
+typedef struct {
+  jweak javaContext;
+  JSValue error_ctor;
+  // Native accessors of Error.stackTraceLimit and Error.prepareStackTrace,
+  // JS_UNDEFINED if the engine has none
+  JSValue limit_get, limit_set;
+  JSValue prepare_get, prepare_set;
+  // Symbol.iterator, JS_ATOM_NULL if the context has no Symbol
+  JSAtom iterator_atom;
+} NativeContextData;
+
+static NativeContextData *get_context_data(JSContext *ctx) {
+  return (NativeContextData *)JS_GetContextOpaque(ctx);
+}
+
+static jobject get_java_context(JNIEnv *env, JSContext *ctx) {
+  NativeContextData *cd = get_context_data(ctx);
+  return cd && cd->javaContext ? (*env)->NewLocalRef(env, cd->javaContext)
+                               : NULL;
+}
+
+// Throw the Java exception for a JS exception. The Java class is picked from
+// the error's name now, since catch clauses need it, but the exception only
+// keeps a handle to the JS value and formats its message and stack when first
+// asked. Falls back to an eagerly formatted message when the context has no
+// Java peer.
+static void throw_java_exception(JNIEnv *env, JSContext *ctx,
+                                 JSValue exception_val) {
+  ErrorClassMapping *mapping = error_class_for(ctx, exception_val);
+
+  jobject javaContext = get_java_context(env, ctx);
+  if (javaContext) {
+    jthrowable ex = NULL;
+    jlong errorPtr = boxJSValue(JS_DupValue(ctx, exception_val));
+    if (errorPtr) {
+      jobject jError = (*env)->NewObject(env, g_JSValueClass, g_JSValue_ctor,
+                                         errorPtr, javaContext);
+      if (jError) {
+        ex = (*env)->NewObject(env, *mapping->cls, mapping->lazy_ctor, jError);
+        (*env)->DeleteLocalRef(env, jError);
+      } else {
+        JS_FreeValue(ctx, *(JSValue *)errorPtr);
+        free((void *)errorPtr);
+      }
+    }
+    (*env)->DeleteLocalRef(env, javaContext);
+    if (ex) {
+      (*env)->Throw(env, ex);
+      (*env)->DeleteLocalRef(env, ex);
+      return;
+    }
+    if ((*env)->ExceptionCheck(env))
+      return;
+  }
+
+  char *msg = describe_exception(ctx, exception_val);
+  (*env)->ThrowNew(env, *mapping->cls, msg ? msg : "Unknown Error");
+  free(msg);
+}
+
+JNIEXPORT jstring JNICALL Java_com_quickjs_JSValue_describeErrorInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *v = (JSValue *)valPtr;
+  if (!ctx || !v)
+    return NULL;
+
+  char *msg = describe_exception(ctx, *v);
+  jstring res = (*env)->NewStringUTF(env, msg ? msg : "Unknown Error");
+  free(msg);
+  return res;
 }
 
 static void check_throw_exception(JNIEnv *env, JSContext *ctx, JSValue val) {
@@ -243,41 +435,656 @@ static void check_throw_exception(JNIEnv *env, JSContext *ctx, JSValue val) {
   }
 }
 
+static int64_t monotonic_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER now;
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (int64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static int64_t monotonic_us(void) { return monotonic_ns() / 1000; }
+
+// CPU time consumed by the calling thread.
+static int64_t thread_cpu_ns(void) {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    return 0;
+  ULARGE_INTEGER k, u;
+  k.LowPart = kernel.dwLowDateTime;
+  k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime;
+  u.HighPart = user.dwHighDateTime;
+  return (int64_t)(k.QuadPart + u.QuadPart) * 100;
+#else
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0;
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// One aggregated profiler bucket, keyed by its collapsed stack
+// ("outer;inner;leaf").
+typedef struct {
+  char *stack;
+  uint32_t hash;
+  uint64_t count;
+} ProfileEntry;
+
+typedef struct {
+  int active;
+  int sampling; // guards against re-entry while capturing a stack
+  int64_t interval_us;
+  int64_t next_sample_us;
+  // Open addressing table, capacity is always a power of two.
+  ProfileEntry *entries;
+  uint32_t capacity;
+  uint32_t size;
+} NativeProfiler;
+
+// Resources used by the current top-level invocation, and the totals of the
+// last finished one.
+typedef struct {
+  int enabled;
+  // Set when a top-level invocation finishes, cleared when Java takes stats.
+  int ready;
+  int64_t start_wall_ns;
+  int64_t start_cpu_ns;
+  uint64_t start_alloc_count;
+  uint64_t start_alloc_bytes;
+  uint64_t start_polls;
+  jlong stats[5];
+} InvocationAccount;
+
 typedef struct {
   JSRuntime *rt;
   // Use a simple int flag. 0 = no interrupt, 1 = interrupt.
   volatile int interrupted;
   jobject moduleLoader;
+  // Context of the innermost eval/call running on this runtime, if any.
+  JSContext *current_ctx;
+  NativeProfiler profiler;
+  // Number of times QuickJS has polled js_interrupt_handler.
+  uint64_t interrupt_polls;
+  // Limits of the running invocations, INT64_MAX/UINT64_MAX when unset.
+  int64_t deadline_us;
+  uint64_t poll_limit;
+  // TIMEOUT_* reason once a limit stopped the script, 0 otherwise.
+  int timed_out;
+  // @JSExport classes registered on this runtime.
+  struct ExportClass **export_classes;
+  int export_class_count;
+  // Host modules registered on this runtime, looked up before moduleLoader.
+  struct HostModule **host_modules;
+  int host_module_count;
+  // Values from JSRuntime.shareFrozen, defined on every context's global,
+  // and the private context they are copied into, NULL until the first.
+  struct SharedValue *shared;
+  int shared_count;
+  JSContext *shared_ctx;
+  // Java JSMetrics recorder while metrics are enabled, NULL otherwise.
+  jobject metrics;
+  // Allocations made through js_counting_malloc_funcs and js_sab_alloc.
+  uint64_t alloc_count;
+  uint64_t alloc_bytes;
+  // Engine heap bytes currently allocated.
+  size_t live_bytes;
+  // SharedArrayBuffer bytes this runtime references, and the limit set by
+  // JSRuntime.setMemoryLimit (0 if none) that they count towards.
+  size_t sab_bytes;
+  size_t memory_limit;
+  InvocationAccount account;
 } NativeRuntimeData;
 
+static void free_export_classes(JNIEnv *env, NativeRuntimeData *data);
+static void free_host_modules(JNIEnv *env, NativeRuntimeData *data);
+static struct HostModule *find_host_module(NativeRuntimeData *data,
+                                           const char *name);
+static JSModuleDef *load_host_module(JSContext *ctx, struct HostModule *mod);
+static void free_shared_values(JSRuntime *rt, NativeRuntimeData *data);
+static void register_java_view_classes(JSRuntime *rt);
+static void register_console_class(JSRuntime *rt);
+
+#define NO_LIMIT (-1)
+#define TIMEOUT_DEADLINE 1
+#define TIMEOUT_BUDGET 2
+
+static NativeRuntimeData *get_runtime_data(JSContext *ctx) {
+  return (NativeRuntimeData *)JS_GetRuntimeOpaque(JS_GetRuntime(ctx));
+}
+
+// Operation codes, matching the order of the Java JSOperation enum
+#define OP_HOST_CALLBACK 2
+#define OP_MODULE_LOAD 3
+#define OP_GC 4
+
+// Report a natively timed operation to the runtime's JSMetrics. Callers only
+// take the start time when data->metrics is set, so disabled metrics cost a
+// pointer check. Must not be called with a Java exception pending.
+static void record_metric(JNIEnv *env, NativeRuntimeData *data, int op,
+                          const char *file_name, const char *function_name,
+                          int64_t start_ns) {
+  jlong elapsed = monotonic_ns() - start_ns;
+  jstring jFile = file_name ? (*env)->NewStringUTF(env, file_name) : NULL;
+  jstring jFunc =
+      function_name ? (*env)->NewStringUTF(env, function_name) : NULL;
+  (*env)->CallVoidMethod(env, data->metrics, g_JSMetrics_record, (jint)op,
+                         jFile, jFunc, elapsed);
+  // A failing listener must not turn into a JS exception
+  if ((*env)->ExceptionCheck(env))
+    (*env)->ExceptionClear(env);
+  (*env)->DeleteLocalRef(env, jFile);
+  (*env)->DeleteLocalRef(env, jFunc);
+}
+
+static int limit_exceeded(NativeRuntimeData *data) {
+  if (data->interrupt_polls >= data->poll_limit)
+    return TIMEOUT_BUDGET;
+  if (data->deadline_us != INT64_MAX && monotonic_us() >= data->deadline_us)
+    return TIMEOUT_DEADLINE;
+  return 0;
+}
+
+// State of the enclosing invocation, restored by leave_invocation().
+typedef struct {
+  JSContext *prev_ctx;
+  int64_t prev_deadline_us;
+  uint64_t prev_poll_limit;
+} InvocationScope;
+
+// Mark ctx as running on its runtime and arm the optional limits. Nested
+// invocations (e.g. eval from inside a Java callback) can only tighten the
+// limits of the enclosing one.
+static void enter_invocation(JSContext *ctx, InvocationScope *scope,
+                             jlong timeoutMicros, jlong interruptBudget) {
+  NativeRuntimeData *data = get_runtime_data(ctx);
+  scope->prev_ctx = data->current_ctx;
+  scope->prev_deadline_us = data->deadline_us;
+  scope->prev_poll_limit = data->poll_limit;
+
+  data->current_ctx = ctx;
+  if (!scope->prev_ctx && data->account.enabled) {
+    InvocationAccount *account = &data->account;
+    account->ready = 0;
+    account->start_wall_ns = monotonic_ns();
+    account->start_cpu_ns = thread_cpu_ns();
+    account->start_alloc_count = data->alloc_count;
+    account->start_alloc_bytes = data->alloc_bytes;
+    account->start_polls = data->interrupt_polls;
+  }
+  if (timeoutMicros != NO_LIMIT) {
+    int64_t deadline = monotonic_us() + timeoutMicros;
+    if (deadline < data->deadline_us)
+      data->deadline_us = deadline;
+  }
+  if (interruptBudget != NO_LIMIT) {
+    uint64_t limit = data->interrupt_polls + (uint64_t)interruptBudget;
+    if (limit < data->poll_limit)
+      data->poll_limit = limit;
+  }
+}
+
+// Returns the TIMEOUT_* reason if a limit stopped this invocation.
+static int leave_invocation(JSContext *ctx, InvocationScope *scope) {
+  NativeRuntimeData *data = get_runtime_data(ctx);
+  int timed_out = data->timed_out;
+  if (!scope->prev_ctx && data->account.enabled) {
+    InvocationAccount *account = &data->account;
+    account->stats[0] = monotonic_ns() - account->start_wall_ns;
+    account->stats[1] = thread_cpu_ns() - account->start_cpu_ns;
+    account->stats[2] = data->alloc_count - account->start_alloc_count;
+    account->stats[3] = data->alloc_bytes - account->start_alloc_bytes;
+    account->stats[4] = data->interrupt_polls - account->start_polls;
+    account->ready = 1;
+  }
+  data->current_ctx = scope->prev_ctx;
+  data->deadline_us = scope->prev_deadline_us;
+  data->poll_limit = scope->prev_poll_limit;
+  // An enclosing invocation whose own limit also expired must see it too.
+  if (timed_out && !limit_exceeded(data))
+    data->timed_out = 0;
+  return timed_out;
+}
+
+// Like check_throw_exception, but reports the uncatchable "interrupted" error
+// raised for an expired deadline or budget as JSTimeoutException.
+static void check_throw_invocation(JNIEnv *env, JSContext *ctx, JSValue val,
+                                   int timed_out) {
+  if (!JS_IsException(val))
+    return;
+  if (!timed_out) {
+    check_throw_exception(env, ctx, val);
+    return;
+  }
+  JS_FreeValue(ctx, JS_GetException(ctx));
+  (*env)->ThrowNew(env, g_JSTimeoutExceptionClass,
+                   timed_out == TIMEOUT_DEADLINE
+                       ? "JS execution exceeded its deadline"
+                       : "JS execution exceeded its interrupt-check budget");
+}
+
+#define PROFILER_MAX_DEPTH 64
+
+static uint32_t profiler_hash(const char *s, size_t len) {
+  uint32_t h = 2166136261u; // FNV-1a
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void profiler_reset(NativeProfiler *prof) {
+  for (uint32_t i = 0; i < prof->capacity; i++) {
+    free(prof->entries[i].stack);
+  }
+  free(prof->entries);
+  prof->entries = NULL;
+  prof->capacity = 0;
+  prof->size = 0;
+}
+
+static int profiler_grow(NativeProfiler *prof) {
+  uint32_t new_capacity = prof->capacity ? prof->capacity * 2 : 64;
+  ProfileEntry *entries = calloc(new_capacity, sizeof(ProfileEntry));
+  if (!entries)
+    return -1;
+  for (uint32_t i = 0; i < prof->capacity; i++) {
+    ProfileEntry *e = &prof->entries[i];
+    if (!e->stack)
+      continue;
+    uint32_t j = e->hash & (new_capacity - 1);
+    while (entries[j].stack)
+      j = (j + 1) & (new_capacity - 1);
+    entries[j] = *e;
+  }
+  free(prof->entries);
+  prof->entries = entries;
+  prof->capacity = new_capacity;
+  return 0;
+}
+
+// Takes ownership of stack.
+static void profiler_record(NativeProfiler *prof, char *stack, size_t len) {
+  if (prof->size * 4 >= prof->capacity * 3 && profiler_grow(prof) < 0) {
+    free(stack);
+    return;
+  }
+  uint32_t hash = profiler_hash(stack, len);
+  uint32_t i = hash & (prof->capacity - 1);
+  while (prof->entries[i].stack) {
+    ProfileEntry *e = &prof->entries[i];
+    if (e->hash == hash && strcmp(e->stack, stack) == 0) {
+      e->count++;
+      free(stack);
+      return;
+    }
+    i = (i + 1) & (prof->capacity - 1);
+  }
+  prof->entries[i].stack = stack;
+  prof->entries[i].hash = hash;
+  prof->entries[i].count = 1;
+  prof->size++;
+}
+
+// Turn an Error.stack trace ("    at inner (f.js:3:5)\n    at outer ...") into
+// a collapsed stack, outermost frame first. Columns are dropped so samples
+// aggregate per line. out must hold strlen(trace) + 1 bytes.
+static size_t profiler_collapse(const char *trace, char *out) {
+  const char *starts[PROFILER_MAX_DEPTH];
+  const char *ends[PROFILER_MAX_DEPTH];
+  int lineOnly[PROFILER_MAX_DEPTH];
+  int depth = 0;
+
+  const char *p = trace;
+  while (*p && depth < PROFILER_MAX_DEPTH) {
+    const char *eol = strchr(p, '\n');
+    if (!eol)
+      eol = p + strlen(p);
+
+    const char *s = p;
+    while (s < eol && *s == ' ')
+      s++;
+    if (eol - s > 3 && strncmp(s, "at ", 3) == 0) {
+      s += 3;
+      const char *e = eol;
+      int trimmed = 0;
+      // "(file:line:col)" -> cut before ":col"
+      if (e[-1] == ')') {
+        const char *q = e - 1;
+        while (q > s && isdigit((unsigned char)q[-1]))
+          q--;
+        if (q < e - 1 && q - 1 > s && q[-1] == ':') {
+          const char *colon = q - 1;
+          const char *t = colon;
+          while (t > s && isdigit((unsigned char)t[-1]))
+            t--;
+          if (t < colon && t - 1 > s && t[-1] == ':') {
+            e = colon;
+            trimmed = 1;
+          }
+        }
+      }
+      starts[depth] = s;
+      ends[depth] = e;
+      lineOnly[depth] = trimmed;
+      depth++;
+    }
+    p = *eol ? eol + 1 : eol;
+  }
+
+  size_t len = 0;
+  for (int i = depth - 1; i >= 0; i--) {
+    if (len > 0)
+      out[len++] = ';';
+    for (const char *c = starts[i]; c < ends[i]; c++) {
+      // ';' separates frames in the collapsed format
+      out[len++] = (*c == ';') ? ':' : *c;
+    }
+    if (lineOnly[i])
+      out[len++] = ')';
+  }
+  out[len] = '\0';
+  return len;
+}
+
+// Call one of the cached native Error accessors, which run no script.
+static JSValue call_error_accessor(JSContext *ctx, NativeContextData *cd,
+                                   JSValueConst fn, JSValueConst arg) {
+  if (!JS_IsFunction(ctx, fn))
+    return JS_UNDEFINED;
+  JSValue res = JS_Call(ctx, fn, cd->error_ctor, 1, (JSValue *)&arg);
+  if (JS_IsException(res)) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return JS_UNDEFINED;
+  }
+  return res;
+}
+
+static void profiler_sample(JSContext *ctx, NativeProfiler *prof) {
+  NativeContextData *cd = get_context_data(ctx);
+  if (!cd)
+    return;
+  // The Error constructor records a backtrace of the frames below it, which
+  // is the cheapest stack walk the public API offers. The intrinsic one is
+  // used with the script's Error.prepareStackTrace unset, so no script runs,
+  // and with Error.stackTraceLimit raised, so deep stacks are not cut short.
+  JSValue limit = call_error_accessor(ctx, cd, cd->limit_get, JS_UNDEFINED);
+  JSValue prepare =
+      call_error_accessor(ctx, cd, cd->prepare_get, JS_UNDEFINED);
+  JS_FreeValue(ctx, call_error_accessor(ctx, cd, cd->limit_set,
+                                        JS_NewInt32(ctx, INT32_MAX)));
+  JS_FreeValue(ctx,
+               call_error_accessor(ctx, cd, cd->prepare_set, JS_UNDEFINED));
+  JSValue err = JS_CallConstructor(ctx, cd->error_ctor, 0, NULL);
+  JS_FreeValue(ctx, call_error_accessor(ctx, cd, cd->limit_set, limit));
+  JS_FreeValue(ctx, call_error_accessor(ctx, cd, cd->prepare_set, prepare));
+  JS_FreeValue(ctx, limit);
+  JS_FreeValue(ctx, prepare);
+  if (JS_IsException(err)) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return;
+  }
+
+  // Read as an own data property, never through a getter on the prototype
+  JSAtom stack_atom = JS_NewAtom(ctx, "stack");
+  JSPropertyDescriptor desc;
+  int found = JS_GetOwnProperty(ctx, &desc, err, stack_atom);
+  JS_FreeAtom(ctx, stack_atom);
+  JS_FreeValue(ctx, err);
+  if (found < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return;
+  }
+  if (!found)
+    return;
+  const char *trace = NULL;
+  if (JS_IsString(desc.value)) {
+    trace = JS_ToCString(ctx, desc.value);
+  }
+  JS_FreeValue(ctx, desc.value);
+  JS_FreeValue(ctx, desc.getter);
+  JS_FreeValue(ctx, desc.setter);
+  if (!trace)
+    return;
+
+  char *collapsed = malloc(strlen(trace) + 1);
+  size_t len = collapsed ? profiler_collapse(trace, collapsed) : 0;
+  JS_FreeCString(ctx, trace);
+  if (len == 0) {
+    free(collapsed);
+    return;
+  }
+  profiler_record(prof, collapsed, len);
+}
+
+static void profiler_poll(NativeRuntimeData *data) {
+  NativeProfiler *prof = &data->profiler;
+  if (prof->sampling || !data->current_ctx)
+    return;
+  int64_t now = monotonic_us();
+  if (now < prof->next_sample_us)
+    return;
+  prof->next_sample_us = now + prof->interval_us;
+
+  prof->sampling = 1;
+  profiler_sample(data->current_ctx, prof);
+  prof->sampling = 0;
+}
+
 static int js_interrupt_handler(JSRuntime *rt, void *opaque) {
   NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  data->interrupt_polls++;
+  if (data->profiler.active)
+    profiler_poll(data);
+  int reason = limit_exceeded(data);
+  if (reason) {
+    data->timed_out = reason;
+    return 1;
+  }
   return data->interrupted;
 }
 
+// --- SharedArrayBuffer memory ---
+//
+// Every runtime allocates SharedArrayBuffer storage from this refcounted
+// allocator, so a buffer serialized in one runtime can be mapped by another
+// and is freed when the last runtime lets go of it. The storage is outside
+// the engine heap, so each runtime charges the buffers it references against
+// its own memory limit and allocation counts; references held by messages in
+// transit (opaque == NULL) are charged to no runtime.
+
+#ifdef _WIN32
+typedef volatile LONG sab_ref_t;
+#define SAB_REF_INC(p) InterlockedIncrement(p)
+#define SAB_REF_DEC(p) InterlockedDecrement(p)
+#else
+typedef int sab_ref_t;
+#define SAB_REF_INC(p) __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define SAB_REF_DEC(p) __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#endif
+
+typedef struct {
+  sab_ref_t ref_count;
+  size_t size;
+  uint64_t buf[]; // keeps the data 8-byte aligned for Atomics
+} SharedBufferHeader;
+
+#define SAB_HEADER(ptr)                                                        \
+  ((SharedBufferHeader *)((uint8_t *)(ptr) -                                   \
+                          offsetof(SharedBufferHeader, buf)))
+
+// Give the engine what is left of the memory limit after the shared buffers
+// this runtime references, so the two together stay under it.
+static void apply_memory_limit(NativeRuntimeData *data) {
+  if (data->memory_limit == 0)
+    return;
+  size_t limit = data->sab_bytes < data->memory_limit
+                     ? data->memory_limit - data->sab_bytes
+                     : 1;
+  JS_SetMemoryLimit(data->rt, limit);
+}
+
+static void *js_sab_alloc(void *opaque, size_t size) {
+  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  if (data && data->memory_limit &&
+      data->live_bytes + data->sab_bytes + size > data->memory_limit)
+    return NULL;
+  SharedBufferHeader *sab = malloc(sizeof(SharedBufferHeader) + size);
+  if (!sab)
+    return NULL;
+  sab->ref_count = 1;
+  sab->size = size;
+  if (data) {
+    data->alloc_count++;
+    data->alloc_bytes += size;
+    data->sab_bytes += size;
+    apply_memory_limit(data);
+  }
+  return sab->buf;
+}
+
+static void js_sab_free(void *opaque, void *ptr) {
+  SharedBufferHeader *sab = SAB_HEADER(ptr);
+  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  if (data) {
+    data->sab_bytes -= sab->size;
+    apply_memory_limit(data);
+  }
+  if (SAB_REF_DEC(&sab->ref_count) == 0)
+    free(sab);
+}
+
+// A runtime mapping a buffer it received is charged for it, but cannot
+// refuse it: the limit then only holds back its own allocations.
+static void js_sab_dup(void *opaque, void *ptr) {
+  SharedBufferHeader *sab = SAB_HEADER(ptr);
+  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  SAB_REF_INC(&sab->ref_count);
+  if (data) {
+    data->sab_bytes += sab->size;
+    apply_memory_limit(data);
+  }
+}
+
+// --- Allocation counting ---
+//
+// The engine keeps its own malloc statistics but only exposes them through
+// JS_ComputeMemoryUsage, which walks the whole heap. These allocator hooks
+// keep running totals in the runtime data instead, so per-invocation
+// accounting can take deltas for free. The engine still enforces the memory
+// limit on top of them.
+
+#ifdef _WIN32
+#define js_usable_size(ptr) _msize((void *)(ptr))
+#elif defined(__APPLE__)
+#define js_usable_size(ptr) malloc_size(ptr)
+#else
+#define js_usable_size(ptr) malloc_usable_size((void *)(ptr))
+#endif
+
+static void count_alloc(void *opaque, void *ptr) {
+  if (ptr) {
+    NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+    size_t size = js_usable_size(ptr);
+    data->alloc_count++;
+    data->alloc_bytes += size;
+    data->live_bytes += size;
+  }
+}
+
+static void *js_counting_calloc(void *opaque, size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  count_alloc(opaque, ptr);
+  return ptr;
+}
+
+static void *js_counting_malloc(void *opaque, size_t size) {
+  void *ptr = malloc(size);
+  count_alloc(opaque, ptr);
+  return ptr;
+}
+
+static void js_counting_free(void *opaque, void *ptr) {
+  if (ptr)
+    ((NativeRuntimeData *)opaque)->live_bytes -= js_usable_size(ptr);
+  free(ptr);
+}
+
+// A reallocation counts as allocating the bytes it grows by.
+static void *js_counting_realloc(void *opaque, void *ptr, size_t size) {
+  if (!ptr)
+    return js_counting_malloc(opaque, size);
+  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  size_t old_size = js_usable_size(ptr);
+  void *new_ptr = realloc(ptr, size);
+  if (new_ptr && size) {
+    size_t new_size = js_usable_size(new_ptr);
+    if (new_size > old_size)
+      data->alloc_bytes += new_size - old_size;
+    data->live_bytes += new_size - old_size;
+  } else if (!size) {
+    data->live_bytes -= old_size;
+  }
+  return new_ptr;
+}
+
+static size_t js_counting_usable_size(const void *ptr) {
+  return ptr ? js_usable_size(ptr) : 0;
+}
+
+static const JSMallocFunctions js_counting_malloc_funcs = {
+    .js_calloc = js_counting_calloc,
+    .js_malloc = js_counting_malloc,
+    .js_free = js_counting_free,
+    .js_realloc = js_counting_realloc,
+    .js_malloc_usable_size = js_counting_usable_size,
+};
+
 JNIEXPORT jlong JNICALL
 Java_com_quickjs_QuickJS_createNativeRuntime(JNIEnv *env, jclass clazz) {
-  JSRuntime *rt = JS_NewRuntime();
-  if (!rt)
+  NativeRuntimeData *data = malloc(sizeof(NativeRuntimeData));
+  if (!data)
     return 0;
+  memset(data, 0, sizeof(NativeRuntimeData));
 
-  NativeRuntimeData *data = malloc(sizeof(NativeRuntimeData));
-  if (!data) {
-    JS_FreeRuntime(rt);
+  // The allocator hooks write to data, so it must outlive the runtime
+  JSRuntime *rt = JS_NewRuntime2(&js_counting_malloc_funcs, data);
+  if (!rt) {
+    free(data);
     return 0;
   }
-  memset(data, 0, sizeof(NativeRuntimeData));
   data->rt = rt;
   data->interrupted = 0;
   data->moduleLoader = NULL;
+  data->deadline_us = INT64_MAX;
+  data->poll_limit = UINT64_MAX;
 
   JS_SetRuntimeOpaque(rt, data);
   JS_SetInterruptHandler(rt, js_interrupt_handler, data);
+  JSSharedArrayBufferFunctions sab_funcs = {
+      .sab_alloc = js_sab_alloc,
+      .sab_free = js_sab_free,
+      .sab_dup = js_sab_dup,
+      .sab_opaque = data,
+  };
+  JS_SetSharedArrayBufferFunctions(rt, &sab_funcs);
 
   if (js_java_proxy_class_id == 0) {
     JS_NewClassID(rt, &js_java_proxy_class_id);
   }
   JS_NewClass(rt, js_java_proxy_class_id, &js_java_proxy_class);
+  register_java_view_classes(rt);
+  register_console_class(rt);
 
   return (jlong)rt;
 }
@@ -286,7 +1093,10 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setMemoryLimitInternal(
     JNIEnv *env, jobject thiz, jlong runtimePtr, jlong limit) {
   JSRuntime *rt = (JSRuntime *)runtimePtr;
   if (rt) {
+    NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
+    data->memory_limit = limit > 0 ? (size_t)limit : 0;
     JS_SetMemoryLimit(rt, (size_t)limit);
+    apply_memory_limit(data);
   }
 }
 
@@ -320,44 +1130,162 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_clearInterruptInternal(
   }
 }
 
-JSModuleDef *js_java_module_loader(JSContext *ctx, const char *module_name,
-                                   void *opaque) {
-  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
-  if (!data || !data->moduleLoader)
-    return NULL;
-
-  jobject loader = data->moduleLoader;
-  if (!loader)
-    return NULL;
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setCanBlockInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jboolean canBlock) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  if (rt) {
+    JS_SetCanBlock(rt, canBlock);
+  }
+}
 
-  JNIEnv *env;
-  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
-    return NULL;
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setMetricsInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jobject metrics) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  NativeRuntimeData *data = rt ? JS_GetRuntimeOpaque(rt) : NULL;
+  if (!data)
+    return;
+  if (data->metrics) {
+    (*env)->DeleteGlobalRef(env, data->metrics);
+    data->metrics = NULL;
+  }
+  if (metrics) {
+    data->metrics = (*env)->NewGlobalRef(env, metrics);
   }
+}
 
-  // loadModule(String moduleName) -> String
-  jclass loaderCls = (*env)->GetObjectClass(env, loader);
-  jmethodID loadMethod = (*env)->GetMethodID(
-      env, loaderCls, "loadModule", "(Ljava/lang/String;)Ljava/lang/String;");
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setAccountingInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jboolean enabled) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  NativeRuntimeData *data = rt ? JS_GetRuntimeOpaque(rt) : NULL;
+  if (data) {
+    data->account.enabled = enabled;
+    data->account.ready = 0;
+  }
+}
 
-  jstring jModuleName = (*env)->NewStringUTF(env, module_name);
-  jstring jContent =
-      (jstring)(*env)->CallObjectMethod(env, loader, loadMethod, jModuleName);
+// Copies the stats of the last finished top-level invocation into out (wall
+// ns, CPU ns, allocations, bytes, interrupt checks). Returns false if none
+// finished since the last call, e.g. when the caller was a nested invocation.
+JNIEXPORT jboolean JNICALL Java_com_quickjs_JSRuntime_takeInvocationStatsInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jlongArray out) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  NativeRuntimeData *data = rt ? JS_GetRuntimeOpaque(rt) : NULL;
+  if (!data || !data->account.ready)
+    return JNI_FALSE;
+  data->account.ready = 0;
+  (*env)->SetLongArrayRegion(env, out, 0, 5, data->account.stats);
+  return JNI_TRUE;
+}
 
-  (*env)->DeleteLocalRef(env, jModuleName);
-  (*env)->DeleteLocalRef(env, loaderCls);
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_runGCInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  NativeRuntimeData *data = rt ? JS_GetRuntimeOpaque(rt) : NULL;
+  if (!data)
+    return;
+  int64_t start = data->metrics ? monotonic_ns() : 0;
+  JS_RunGC(rt);
+  if (data->metrics) {
+    record_metric(env, data, OP_GC, NULL, NULL, start);
+  }
+}
 
-  if ((*env)->ExceptionCheck(env)) {
-    jthrowable ex = (*env)->ExceptionOccurred(env);
-    (*env)->ExceptionClear(env);
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_startProfilingInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jlong intervalMicros) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  if (!rt)
+    return;
+  NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
+  if (!data)
+    return;
 
-    jclass exCls = (*env)->GetObjectClass(env, ex);
-    jmethodID toString =
-        (*env)->GetMethodID(env, exCls, "toString", "()Ljava/lang/String;");
-    jstring jMsg = (jstring)(*env)->CallObjectMethod(env, ex, toString);
-    const char *cMsg = GetStringUTFChars(env, jMsg);
+  NativeProfiler *prof = &data->profiler;
+  profiler_reset(prof);
+  prof->interval_us = intervalMicros > 0 ? intervalMicros : 1;
+  prof->next_sample_us = monotonic_us() + prof->interval_us;
+  prof->active = 1;
+}
 
-    JS_ThrowTypeError(ctx, "Java Module Loader failed: %s", cMsg);
+JNIEXPORT jstring JNICALL Java_com_quickjs_JSRuntime_stopProfilingInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  if (!rt)
+    return NULL;
+  NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
+  if (!data)
+    return NULL;
+
+  NativeProfiler *prof = &data->profiler;
+  prof->active = 0;
+
+  // Collapsed-stack text: one "frame;frame;frame count" line per bucket.
+  size_t size = 1;
+  for (uint32_t i = 0; i < prof->capacity; i++) {
+    if (prof->entries[i].stack)
+      size += strlen(prof->entries[i].stack) + 22;
+  }
+  char *buf = malloc(size);
+  if (!buf) {
+    profiler_reset(prof);
+    return NULL;
+  }
+  size_t len = 0;
+  buf[0] = '\0';
+  for (uint32_t i = 0; i < prof->capacity; i++) {
+    ProfileEntry *e = &prof->entries[i];
+    if (e->stack)
+      len += snprintf(buf + len, size - len, "%s %llu\n", e->stack,
+                      (unsigned long long)e->count);
+  }
+  profiler_reset(prof);
+
+  jstring res = (*env)->NewStringUTF(env, buf);
+  free(buf);
+  return res;
+}
+
+static JSModuleDef *load_java_module(JSContext *ctx, const char *module_name,
+                                     NativeRuntimeData *data) {
+  if (!data)
+    return NULL;
+  struct HostModule *host = find_host_module(data, module_name);
+  if (host)
+    return load_host_module(ctx, host);
+  if (!data->moduleLoader)
+    return NULL;
+
+  jobject loader = data->moduleLoader;
+  if (!loader)
+    return NULL;
+
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+    return NULL;
+  }
+
+  // loadModule(String moduleName) -> String
+  jclass loaderCls = (*env)->GetObjectClass(env, loader);
+  jmethodID loadMethod = (*env)->GetMethodID(
+      env, loaderCls, "loadModule", "(Ljava/lang/String;)Ljava/lang/String;");
+
+  jstring jModuleName = (*env)->NewStringUTF(env, module_name);
+  jstring jContent =
+      (jstring)(*env)->CallObjectMethod(env, loader, loadMethod, jModuleName);
+
+  (*env)->DeleteLocalRef(env, jModuleName);
+  (*env)->DeleteLocalRef(env, loaderCls);
+
+  if ((*env)->ExceptionCheck(env)) {
+    jthrowable ex = (*env)->ExceptionOccurred(env);
+    (*env)->ExceptionClear(env);
+
+    jclass exCls = (*env)->GetObjectClass(env, ex);
+    jmethodID toString =
+        (*env)->GetMethodID(env, exCls, "toString", "()Ljava/lang/String;");
+    jstring jMsg = (jstring)(*env)->CallObjectMethod(env, ex, toString);
+    const char *cMsg = GetStringUTFChars(env, jMsg);
+
+    JS_ThrowTypeError(ctx, "Java Module Loader failed: %s", cMsg);
 
     ReleaseStringUTFChars(env, jMsg, cMsg);
     (*env)->DeleteLocalRef(env, jMsg);
@@ -386,6 +1314,24 @@ JSModuleDef *js_java_module_loader(JSContext *ctx, const char *module_name,
   return (JSModuleDef *)JS_VALUE_GET_PTR(val);
 }
 
+// Fetches and compiles a module through the Java JSModuleLoader, timed as
+// OP_MODULE_LOAD when metrics are enabled.
+JSModuleDef *js_java_module_loader(JSContext *ctx, const char *module_name,
+                                   void *opaque) {
+  NativeRuntimeData *data = (NativeRuntimeData *)opaque;
+  if (!data || !data->metrics)
+    return load_java_module(ctx, module_name, data);
+
+  int64_t start = monotonic_ns();
+  JSModuleDef *m = load_java_module(ctx, module_name, data);
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) == JNI_OK &&
+      !(*env)->ExceptionCheck(env)) {
+    record_metric(env, data, OP_MODULE_LOAD, module_name, NULL, start);
+  }
+  return m;
+}
+
 JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setModuleLoaderInternal(
     JNIEnv *env, jobject thiz, jlong runtimePtr, jobject loader) {
   JSRuntime *rt = (JSRuntime *)runtimePtr;
@@ -412,7 +1358,7 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_setModuleLoaderInternal(
 
 JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_evalInternal(
     JNIEnv *env, jobject thiz, jlong contextPtr, jstring script,
-    jstring fileName, jint type) {
+    jstring fileName, jint type, jlong timeoutMicros, jlong interruptBudget) {
 
   JSContext *ctx = (JSContext *)contextPtr;
   CHECK_CONTEXT(ctx);
@@ -422,12 +1368,15 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_evalInternal(
 
   const char *c_filename = GetStringUTFChars(env, fileName);
 
+  InvocationScope scope;
+  enter_invocation(ctx, &scope, timeoutMicros, interruptBudget);
   JSValue val = JS_Eval(ctx, c_script, strlen(c_script), c_filename, type);
+  int timed_out = leave_invocation(ctx, &scope);
 
   ReleaseStringUTFChars(env, script, c_script);
   ReleaseStringUTFChars(env, fileName, c_filename);
 
-  check_throw_exception(env, ctx, val);
+  check_throw_invocation(env, ctx, val, timed_out);
   if (JS_IsException(val)) {
     return 0;
   }
@@ -435,9 +1384,9 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_evalInternal(
   return boxJSValue(val);
 }
 
-// Update freeNativeRuntime to release loader
-JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_freeNativeRuntime(
-    JNIEnv *env, jobject thiz, jlong runtimePtr) {
+// Called by the runtime's cleaner once every context and value is freed
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_freeRuntimeInternal(
+    JNIEnv *env, jclass clazz, jlong runtimePtr) {
   JSRuntime *rt = (JSRuntime *)runtimePtr;
   if (rt) {
     NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
@@ -445,38 +1394,253 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_freeNativeRuntime(
       if (data->moduleLoader) {
         (*env)->DeleteGlobalRef(env, data->moduleLoader);
       }
-      free(data);
+      if (data->metrics) {
+        (*env)->DeleteGlobalRef(env, data->metrics);
+      }
+      profiler_reset(&data->profiler);
+      free_export_classes(env, data);
+      free_host_modules(env, data);
+      free_shared_values(rt, data);
     }
     JS_FreeRuntime(rt);
+    free(data);
   }
 }
 
 // ... Rest of file methods needing restoration ...
 
+// Bits of the Java JSIntrinsic enum, in the order JS_NewContext adds them.
+static void (*const g_intrinsics[])(JSContext *) = {
+    JS_AddIntrinsicDate,    JS_AddIntrinsicEval,
+    JS_AddIntrinsicStringNormalize,
+    JS_AddIntrinsicRegExp,  JS_AddIntrinsicJSON,
+    JS_AddIntrinsicProxy,   JS_AddIntrinsicMapSet,
+    JS_AddIntrinsicTypedArrays,
+    JS_AddIntrinsicPromise, JS_AddIntrinsicBigInt,
+    JS_AddIntrinsicWeakRef, JS_AddIntrinsicPerformance,
+};
+
+#define INTRINSIC_COUNT ((int)(sizeof(g_intrinsics) / sizeof(g_intrinsics[0])))
+#define INTRINSIC_ALL ((1 << INTRINSIC_COUNT) - 1)
+#define INTRINSIC_EVAL_INDEX 1
+#define INTRINSIC_PROMISE_INDEX 8
+
+// Stands in for the Function, GeneratorFunction and AsyncFunction
+// constructors of a context without JSIntrinsic.EVAL. data[0] is the
+// intrinsic EvalError constructor.
+static JSValue js_deny_function_ctor(JSContext *ctx, JSValueConst this_val,
+                                     int argc, JSValueConst *argv, int magic,
+                                     JSValue *func_data) {
+  JSValue msg =
+      JS_NewString(ctx, "code generation from strings is disabled");
+  if (JS_IsException(msg))
+    return msg;
+  JSValue err = JS_CallConstructor(ctx, func_data[0], 1, &msg);
+  JS_FreeValue(ctx, msg);
+  if (JS_IsException(err))
+    return err;
+  return JS_Throw(ctx, err);
+}
+
+// The prototypes of generator and async functions are only reachable from
+// such a function, which only the compiler creates. Compiled separately so
+// a context without Promise compiles no async function.
+static const char g_generator_function_expr[] = "(function* () {})";
+static const char g_async_function_expr[] =
+    "[async function () {}, async function* () {}]";
+
+// Point constructor of the prototype of each function fn evaluates to at
+// deny. Only parses the tiny function expressions above.
+static int deny_constructors_of(JSContext *ctx, JSValueConst deny,
+                                const char *expr, size_t len) {
+  JSValue val = JS_Eval(ctx, expr, len, "<intrinsics>", JS_EVAL_TYPE_GLOBAL);
+  if (JS_IsException(val))
+    return -1;
+  int count = JS_IsArray(val) ? 2 : 1;
+  int ret = 0;
+  for (int i = 0; i < count && ret == 0; i++) {
+    JSValue fn = count == 1 ? JS_DupValue(ctx, val)
+                            : JS_GetPropertyUint32(ctx, val, i);
+    JSValue proto = JS_GetPrototype(ctx, fn);
+    JS_FreeValue(ctx, fn);
+    if (JS_IsException(proto)) {
+      ret = -1;
+      break;
+    }
+    ret = JS_DefinePropertyValueStr(ctx, proto, "constructor",
+                                    JS_DupValue(ctx, deny),
+                                    JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    JS_FreeValue(ctx, proto);
+  }
+  JS_FreeValue(ctx, val);
+  return ret < 0 ? -1 : 0;
+}
+
+// Remove the ways scripts compile code from strings. eval is deleted, and
+// Function, like the constructor property of every function prototype,
+// becomes a function that throws EvalError. It keeps Function.prototype,
+// so instanceof Function and typeof Function behave as before.
+static int disable_js_eval(JSContext *ctx, int intrinsics) {
+  JSValue global = JS_GetGlobalObject(ctx);
+  JSValue function_ctor = JS_GetPropertyStr(ctx, global, "Function");
+  JSValue function_proto = JS_GetPropertyStr(ctx, function_ctor, "prototype");
+  JSValue eval_error = JS_GetPropertyStr(ctx, global, "EvalError");
+  JS_FreeValue(ctx, function_ctor);
+  JSValue deny =
+      JS_NewCFunctionData(ctx, js_deny_function_ctor, 1, 0, 1, &eval_error);
+  JS_FreeValue(ctx, eval_error);
+
+  int ret = -1;
+  if (!JS_IsException(deny) && JS_IsObject(function_proto)) {
+    JSAtom eval_atom = JS_NewAtom(ctx, "eval");
+    ret = JS_DeleteProperty(ctx, global, eval_atom, 0);
+    JS_FreeAtom(ctx, eval_atom);
+  }
+  if (ret >= 0) {
+    JS_DefinePropertyValueStr(ctx, deny, "name",
+                              JS_NewString(ctx, "Function"),
+                              JS_PROP_CONFIGURABLE);
+    // Sets deny.prototype and Function.prototype.constructor
+    JS_SetConstructor(ctx, deny, function_proto);
+    JS_SetConstructorBit(ctx, deny, 1);
+    ret = JS_DefinePropertyValueStr(ctx, global, "Function",
+                                    JS_DupValue(ctx, deny),
+                                    JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+  }
+  if (ret >= 0)
+    ret = deny_constructors_of(ctx, deny, g_generator_function_expr,
+                               sizeof(g_generator_function_expr) - 1);
+  if (ret >= 0 && (intrinsics & (1 << INTRINSIC_PROMISE_INDEX)))
+    ret = deny_constructors_of(ctx, deny, g_async_function_expr,
+                               sizeof(g_async_function_expr) - 1);
+  JS_FreeValue(ctx, deny);
+  JS_FreeValue(ctx, function_proto);
+  JS_FreeValue(ctx, global);
+  if (ret < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return -1;
+  }
+  return 0;
+}
+
+// The accessor pair of an own property, JS_UNDEFINED for a data property or
+// none at all.
+static void get_own_accessors(JSContext *ctx, JSValueConst obj,
+                              const char *name, JSValue *getter,
+                              JSValue *setter) {
+  *getter = JS_UNDEFINED;
+  *setter = JS_UNDEFINED;
+  JSAtom atom = JS_NewAtom(ctx, name);
+  JSPropertyDescriptor desc;
+  int found = JS_GetOwnProperty(ctx, &desc, obj, atom);
+  JS_FreeAtom(ctx, atom);
+  if (found < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return;
+  }
+  if (!found)
+    return;
+  JS_FreeValue(ctx, desc.value);
+  *getter = desc.getter;
+  *setter = desc.setter;
+}
+
+// Called before the context runs any script.
+static int init_context_data(JSContext *ctx) {
+  NativeContextData *cd = calloc(1, sizeof(NativeContextData));
+  if (!cd)
+    return -1;
+  JSValue global = JS_GetGlobalObject(ctx);
+  cd->error_ctor = JS_GetPropertyStr(ctx, global, "Error");
+  if (!JS_IsObject(cd->error_ctor)) {
+    JS_FreeValue(ctx, cd->error_ctor);
+    JS_FreeValue(ctx, global);
+    free(cd);
+    return -1;
+  }
+  get_own_accessors(ctx, cd->error_ctor, "stackTraceLimit", &cd->limit_get,
+                    &cd->limit_set);
+  get_own_accessors(ctx, cd->error_ctor, "prepareStackTrace",
+                    &cd->prepare_get, &cd->prepare_set);
+  JSValue symbol = JS_GetPropertyStr(ctx, global, "Symbol");
+  JSValue sym_iterator = JS_GetPropertyStr(ctx, symbol, "iterator");
+  if (JS_IsException(sym_iterator))
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  cd->iterator_atom = JS_IsSymbol(sym_iterator)
+                          ? JS_ValueToAtom(ctx, sym_iterator)
+                          : JS_ATOM_NULL;
+  JS_FreeValue(ctx, sym_iterator);
+  JS_FreeValue(ctx, symbol);
+  JS_FreeValue(ctx, global);
+  JS_SetContextOpaque(ctx, cd);
+  return 0;
+}
+
+// The engine keeps a context alive while objects of its realm are, e.g.
+// values shared with JSRuntime.shareFrozen, so its opaque is cleared rather
+// than left dangling.
+static void free_context(JNIEnv *env, JSContext *ctx) {
+  NativeContextData *cd = get_context_data(ctx);
+  if (cd) {
+    JS_SetContextOpaque(ctx, NULL);
+    if (cd->javaContext)
+      (*env)->DeleteWeakGlobalRef(env, cd->javaContext);
+    JS_FreeValue(ctx, cd->error_ctor);
+    JS_FreeValue(ctx, cd->limit_get);
+    JS_FreeValue(ctx, cd->limit_set);
+    JS_FreeValue(ctx, cd->prepare_get);
+    JS_FreeValue(ctx, cd->prepare_set);
+    JS_FreeAtom(ctx, cd->iterator_atom);
+    free(cd);
+  }
+  JS_FreeContext(ctx);
+}
+
+static JSContext *new_context(JSRuntime *rt, jint intrinsics) {
+  // Everything is what JS_NewContext builds, so take the stock path
+  if ((intrinsics & INTRINSIC_ALL) == INTRINSIC_ALL)
+    return JS_NewContext(rt);
+
+  JSContext *ctx = JS_NewContextRaw(rt);
+  if (!ctx)
+    return NULL;
+  JS_AddIntrinsicBaseObjects(ctx);
+  // The eval hook is the compiler behind every JS_Eval, Java's included, so
+  // it is always installed; the EVAL bit only controls access from JS
+  JS_AddIntrinsicEval(ctx);
+  for (int i = 0; i < INTRINSIC_COUNT; i++) {
+    if (i != INTRINSIC_EVAL_INDEX && (intrinsics & (1 << i)))
+      g_intrinsics[i](ctx);
+  }
+  return ctx;
+}
+
 JNIEXPORT jlong JNICALL Java_com_quickjs_JSRuntime_createNativeContext(
-    JNIEnv *env, jobject thiz, jlong runtimePtr, jboolean withStdLib) {
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jint intrinsics) {
   JSRuntime *rt = (JSRuntime *)runtimePtr;
   if (!rt)
     return 0;
 
-  JSContext *ctx;
-  if (withStdLib) {
-    ctx = JS_NewContext(rt);
-  } else {
-    ctx = JS_NewContextRaw(rt);
-    if (ctx) {
-      JS_AddIntrinsicBaseObjects(ctx);
-      JS_AddIntrinsicEval(ctx);
-    }
+  JSContext *ctx = new_context(rt, intrinsics);
+  if (!ctx)
+    return 0;
+  if (init_context_data(ctx) < 0) {
+    JS_FreeContext(ctx);
+    return 0;
+  }
+  if (!(intrinsics & (1 << INTRINSIC_EVAL_INDEX)) &&
+      disable_js_eval(ctx, intrinsics) < 0) {
+    free_context(env, ctx);
+    return 0;
   }
   return (jlong)ctx;
 }
 
-JNIEXPORT void JNICALL Java_com_quickjs_JSContext_freeNativeContext(
-    JNIEnv *env, jobject thiz, jlong contextPtr) {
+JNIEXPORT void JNICALL Java_com_quickjs_JSReleaseQueue_freeContextInternal(
+    JNIEnv *env, jclass clazz, jlong contextPtr) {
   JSContext *ctx = (JSContext *)contextPtr;
   if (ctx) {
-    JS_FreeContext(ctx);
+    free_context(env, ctx);
   }
 }
 
@@ -485,8 +1649,8 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSContext_registerJavaContext(
   JSContext *ctx = (JSContext *)contextPtr;
   if (!ctx)
     return;
-  jweak globalCtx = (*env)->NewWeakGlobalRef(env, javaContext);
-  JS_SetContextOpaque(ctx, globalCtx);
+  get_context_data(ctx)->javaContext =
+      (*env)->NewWeakGlobalRef(env, javaContext);
 }
 
 JNIEXPORT jint JNICALL Java_com_quickjs_JSValue_getTagInternal(JNIEnv *env,
@@ -609,9 +1773,47 @@ JNIEXPORT void JNICALL Java_com_quickjs_JSValue_setPropertyIdxInternal(
   }
 }
 
+// The own "name" data property of a function, for metrics tags; NULL for
+// anything else. Runs no script, so accessors and proxies are skipped, and
+// leaves no exception behind.
+JNIEXPORT jstring JNICALL Java_com_quickjs_JSValue_functionNameInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong funcPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *func = (JSValue *)funcPtr;
+  if (!ctx || !func || !JS_IsObject(*func) || JS_IsProxy(*func))
+    return NULL;
+
+  JSAtom atom = JS_NewAtom(ctx, "name");
+  JSPropertyDescriptor desc;
+  int found = JS_GetOwnProperty(ctx, &desc, *func, atom);
+  JS_FreeAtom(ctx, atom);
+  if (found < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return NULL;
+  }
+  if (!found)
+    return NULL;
+  jstring res = NULL;
+  if (!(desc.flags & JS_PROP_GETSET) && JS_IsString(desc.value)) {
+    const char *c_name = JS_ToCString(ctx, desc.value);
+    if (c_name) {
+      res = (*env)->NewStringUTF(env, c_name);
+      JS_FreeCString(ctx, c_name);
+    } else {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+    if ((*env)->ExceptionCheck(env))
+      (*env)->ExceptionClear(env);
+  }
+  JS_FreeValue(ctx, desc.value);
+  JS_FreeValue(ctx, desc.getter);
+  JS_FreeValue(ctx, desc.setter);
+  return res;
+}
+
 JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_callInternal(
     JNIEnv *env, jobject thiz, jlong contextPtr, jlong funcPtr, jlong thisPtr,
-    jlongArray args) {
+    jlongArray args, jlong timeoutMicros, jlong interruptBudget) {
   JSContext *ctx = (JSContext *)contextPtr;
   JSValue *func = (JSValue *)funcPtr;
   JSValue this_val;
@@ -634,7 +1836,10 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_callInternal(
     }
   }
 
+  InvocationScope scope;
+  enter_invocation(ctx, &scope, timeoutMicros, interruptBudget);
   JSValue result = JS_Call(ctx, *func, this_val, argc, argv);
+  int timed_out = leave_invocation(ctx, &scope);
 
   if (argPtrs) {
     (*env)->ReleaseLongArrayElements(env, args, argPtrs, JNI_ABORT);
@@ -643,7 +1848,7 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_callInternal(
     free(argv);
   }
 
-  check_throw_exception(env, ctx, result);
+  check_throw_invocation(env, ctx, result, timed_out);
   if (JS_IsException(result)) {
     return 0;
   }
@@ -651,6 +1856,255 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_callInternal(
   return boxJSValue(result);
 }
 
+// --- FFM downcalls ---
+//
+// Plain C entry points for the JDK 22+ classes of the multi-release jar,
+// which bind them with the Foreign Function & Memory API instead of going
+// through JNI. Except quickjs_ffm_free_value, which may run finalizers that
+// call back into the JVM, they neither allocate nor call out, so Java may
+// bind them as critical downcalls. Pointers are passed as int64_t to match
+// the jlong handles used everywhere else.
+
+JNIEXPORT int32_t quickjs_ffm_tag(int64_t valPtr) {
+  return JS_VALUE_GET_NORM_TAG(*(JSValue *)valPtr);
+}
+
+JNIEXPORT int32_t quickjs_ffm_get_int(int64_t valPtr) {
+  return JS_VALUE_GET_INT(*(JSValue *)valPtr);
+}
+
+JNIEXPORT double quickjs_ffm_get_float64(int64_t valPtr) {
+  return JS_VALUE_GET_FLOAT64(*(JSValue *)valPtr);
+}
+
+JNIEXPORT int32_t quickjs_ffm_is_array(int64_t valPtr) {
+  return JS_IsArray(*(JSValue *)valPtr);
+}
+
+JNIEXPORT int32_t quickjs_ffm_is_function(int64_t contextPtr, int64_t valPtr) {
+  return JS_IsFunction((JSContext *)contextPtr, *(JSValue *)valPtr);
+}
+
+JNIEXPORT int32_t quickjs_ffm_is_error(int64_t valPtr) {
+  return JS_IsError(*(JSValue *)valPtr);
+}
+
+JNIEXPORT void quickjs_ffm_free_value(int64_t runtimePtr, int64_t valPtr) {
+  JSValue *v = (JSValue *)valPtr;
+  JS_FreeValueRT((JSRuntime *)runtimePtr, *v);
+  free(v);
+}
+
+// --- Columnar batch calls ---
+//
+// mapBatch calls one function per row with arguments read straight from
+// Java columns, so a row costs one JS_Call rather than several JNI crossings
+// and JSValue wrappers. Column kinds: I J D Z for int[], long[], double[],
+// boolean[]; i j d for direct Int/Long/DoubleBuffers; S for String[].
+
+typedef struct {
+  char kind;
+  jobject array;
+  void *data;
+} BatchColumn;
+
+static int batch_acquire(JNIEnv *env, BatchColumn *col) {
+  switch (col->kind) {
+  case 'I':
+    col->data = (*env)->GetIntArrayElements(env, col->array, NULL);
+    break;
+  case 'J':
+    col->data = (*env)->GetLongArrayElements(env, col->array, NULL);
+    break;
+  case 'D':
+    col->data = (*env)->GetDoubleArrayElements(env, col->array, NULL);
+    break;
+  case 'Z':
+    col->data = (*env)->GetBooleanArrayElements(env, col->array, NULL);
+    break;
+  case 'i':
+  case 'j':
+  case 'd':
+    col->data = (*env)->GetDirectBufferAddress(env, col->array);
+    break;
+  case 'S':
+    return 0;
+  }
+  return col->data ? 0 : -1;
+}
+
+// mode is 0 to copy back an output column, JNI_ABORT for an input
+static void batch_release(JNIEnv *env, BatchColumn *col, jint mode) {
+  if (!col->data)
+    return;
+  switch (col->kind) {
+  case 'I':
+    (*env)->ReleaseIntArrayElements(env, col->array, col->data, mode);
+    break;
+  case 'J':
+    (*env)->ReleaseLongArrayElements(env, col->array, col->data, mode);
+    break;
+  case 'D':
+    (*env)->ReleaseDoubleArrayElements(env, col->array, col->data, mode);
+    break;
+  case 'Z':
+    (*env)->ReleaseBooleanArrayElements(env, col->array, col->data, mode);
+    break;
+  }
+  col->data = NULL;
+}
+
+static JSValue batch_read(JNIEnv *env, JSContext *ctx, BatchColumn *col,
+                          jint row) {
+  switch (col->kind) {
+  case 'I':
+  case 'i':
+    return JS_NewInt32(ctx, ((jint *)col->data)[row]);
+  case 'J':
+  case 'j':
+    return JS_NewInt64(ctx, ((jlong *)col->data)[row]);
+  case 'D':
+  case 'd':
+    return JS_NewFloat64(ctx, ((jdouble *)col->data)[row]);
+  case 'Z':
+    return JS_NewBool(ctx, ((jboolean *)col->data)[row]);
+  }
+  jstring str = (jstring)(*env)->GetObjectArrayElement(env, col->array, row);
+  if (!str)
+    return JS_NULL;
+  const char *chars = GetStringUTFChars(env, str);
+  JSValue val = chars ? JS_NewString(ctx, chars) : JS_ThrowOutOfMemory(ctx);
+  ReleaseStringUTFChars(env, str, chars);
+  (*env)->DeleteLocalRef(env, str);
+  return val;
+}
+
+static int batch_write(JNIEnv *env, JSContext *ctx, BatchColumn *col, jint row,
+                       JSValueConst val) {
+  switch (col->kind) {
+  case 'I':
+  case 'i': {
+    int32_t v;
+    if (JS_ToInt32(ctx, &v, val) < 0)
+      return -1;
+    ((jint *)col->data)[row] = v;
+    return 0;
+  }
+  case 'J':
+  case 'j': {
+    int64_t v;
+    if (JS_ToInt64(ctx, &v, val) < 0)
+      return -1;
+    ((jlong *)col->data)[row] = v;
+    return 0;
+  }
+  case 'D':
+  case 'd':
+    return JS_ToFloat64(ctx, &((jdouble *)col->data)[row], val);
+  case 'Z': {
+    int b = JS_ToBool(ctx, val);
+    if (b < 0)
+      return -1;
+    ((jboolean *)col->data)[row] = b ? JNI_TRUE : JNI_FALSE;
+    return 0;
+  }
+  }
+  jstring str = NULL;
+  if (!JS_IsNull(val) && !JS_IsUndefined(val)) {
+    const char *chars = JS_ToCString(ctx, val);
+    if (!chars)
+      return -1;
+    str = (*env)->NewStringUTF(env, chars);
+    JS_FreeCString(ctx, chars);
+    if (!str) {
+      JS_ThrowOutOfMemory(ctx);
+      return -1;
+    }
+  }
+  (*env)->SetObjectArrayElement(env, col->array, row, str);
+  (*env)->DeleteLocalRef(env, str);
+  return 0;
+}
+
+JNIEXPORT void JNICALL Java_com_quickjs_JSContext_mapBatchInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong funcPtr,
+    jobjectArray columns, jstring kinds, jint rowCount, jobject output,
+    jchar outputKind, jlong timeoutMicros, jlong interruptBudget) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *func = (JSValue *)funcPtr;
+  if (!ctx || !func)
+    return;
+
+  int argc = (*env)->GetArrayLength(env, columns);
+  BatchColumn *cols = calloc(argc + 1, sizeof(BatchColumn));
+  JSValue *argv = malloc(sizeof(JSValue) * (argc > 0 ? argc : 1));
+  const char *c_kinds = GetStringUTFChars(env, kinds);
+  if (!cols || !argv || !c_kinds) {
+    free(cols);
+    free(argv);
+    ReleaseStringUTFChars(env, kinds, c_kinds);
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass, "Native Error: OOM in mapBatch");
+    return;
+  }
+
+  // cols[argc] is the output column
+  int ok = 1;
+  for (int i = 0; i <= argc && ok; i++) {
+    cols[i].kind = i < argc ? c_kinds[i] : (char)outputKind;
+    cols[i].array = i < argc ? (*env)->GetObjectArrayElement(env, columns, i)
+                             : (*env)->NewLocalRef(env, output);
+    ok = batch_acquire(env, &cols[i]) == 0;
+  }
+  ReleaseStringUTFChars(env, kinds, c_kinds);
+
+  JSValue result = JS_UNDEFINED;
+  int timed_out = 0;
+  if (ok) {
+    InvocationScope scope;
+    enter_invocation(ctx, &scope, timeoutMicros, interruptBudget);
+    for (jint row = 0; row < rowCount; row++) {
+      int i = 0;
+      for (; i < argc; i++) {
+        argv[i] = batch_read(env, ctx, &cols[i], row);
+        if (JS_IsException(argv[i]))
+          break;
+      }
+      if (i == argc) {
+        result = JS_Call(ctx, *func, JS_UNDEFINED, argc, argv);
+      } else {
+        result = JS_EXCEPTION;
+      }
+      while (i-- > 0)
+        JS_FreeValue(ctx, argv[i]);
+      if (!JS_IsException(result) &&
+          batch_write(env, ctx, &cols[argc], row, result) < 0) {
+        JS_FreeValue(ctx, result);
+        result = JS_EXCEPTION;
+      }
+      if (JS_IsException(result))
+        break;
+      JS_FreeValue(ctx, result);
+      result = JS_UNDEFINED;
+    }
+    timed_out = leave_invocation(ctx, &scope);
+  }
+
+  for (int i = 0; i <= argc; i++) {
+    batch_release(env, &cols[i], i < argc ? JNI_ABORT : 0);
+    (*env)->DeleteLocalRef(env, cols[i].array);
+  }
+  free(cols);
+  free(argv);
+
+  if (!ok) {
+    if (!(*env)->ExceptionCheck(env))
+      (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                       "Native Error: cannot access mapBatch column");
+    return;
+  }
+  check_throw_invocation(env, ctx, result, timed_out);
+}
+
 JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_parseJSONInternal(
     JNIEnv *env, jobject thiz, jlong contextPtr, jstring json) {
   JSContext *ctx = (JSContext *)contextPtr;
@@ -659,197 +2113,2089 @@ JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_parseJSONInternal(
   const char *c_json = GetStringUTFChars(env, json);
   CHECK_PTR(c_json, 0);
 
-  JSValue val = JS_ParseJSON(ctx, c_json, strlen(c_json), "<input>");
+  JSValue val = JS_ParseJSON(ctx, c_json, strlen(c_json), "<input>");
+
+  ReleaseStringUTFChars(env, json, c_json);
+
+  check_throw_exception(env, ctx, val);
+  if (JS_IsException(val)) {
+    return 0;
+  }
+
+  return boxJSValue(val);
+}
+
+JNIEXPORT jstring JNICALL Java_com_quickjs_JSValue_toJSONInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *v = (JSValue *)valPtr;
+
+  JSValue jsonStrVal = JS_JSONStringify(ctx, *v, JS_UNDEFINED, JS_UNDEFINED);
+
+  check_throw_exception(env, ctx, jsonStrVal);
+  if (JS_IsException(jsonStrVal)) {
+    return NULL;
+  }
+
+  const char *str = JS_ToCString(ctx, jsonStrVal);
+  jstring res = (*env)->NewStringUTF(env, str);
+
+  JS_FreeCString(ctx, str);
+  JS_FreeValue(ctx, jsonStrVal);
+
+  return res;
+}
+
+// Structured serialization: the QuickJS object format keeps types, shared
+// references and cycles, unlike JSON text. Buffers are only readable by the
+// same QuickJS build.
+#define SERIALIZE_FLAGS JS_WRITE_OBJ_REFERENCE
+#define DESERIALIZE_FLAGS JS_READ_OBJ_REFERENCE
+
+JNIEXPORT jbyteArray JNICALL Java_com_quickjs_JSValue_serializeInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *v = (JSValue *)valPtr;
+
+  size_t size;
+  uint8_t *buf = JS_WriteObject(ctx, &size, *v, SERIALIZE_FLAGS);
+  if (!buf) {
+    check_throw_exception(env, ctx, JS_EXCEPTION);
+    return NULL;
+  }
+
+  jbyteArray res = (*env)->NewByteArray(env, (jsize)size);
+  if (res) {
+    (*env)->SetByteArrayRegion(env, res, 0, (jsize)size, (const jbyte *)buf);
+  }
+  js_free(ctx, buf);
+  return res;
+}
+
+static jlong deserialize(JNIEnv *env, JSContext *ctx, const uint8_t *buf,
+                         size_t len) {
+  JSValue val = JS_ReadObject(ctx, buf, len, DESERIALIZE_FLAGS);
+  check_throw_exception(env, ctx, val);
+  if (JS_IsException(val)) {
+    return 0;
+  }
+  return boxJSValue(val);
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_deserializeInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jbyteArray data, jint offset,
+    jint length) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  CHECK_CONTEXT(ctx);
+
+  // Not a critical region: reading may run GC finalizers that call into JNI
+  jbyte *bytes = (*env)->GetByteArrayElements(env, data, NULL);
+  CHECK_PTR(bytes, 0);
+  jlong res = deserialize(env, ctx, (const uint8_t *)bytes + offset, length);
+  (*env)->ReleaseByteArrayElements(env, data, bytes, JNI_ABORT);
+  return res;
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_deserializeDirectInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jobject buffer, jint offset,
+    jint length) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  CHECK_CONTEXT(ctx);
+
+  // Read straight from the buffer's memory, no copy
+  uint8_t *bytes = (*env)->GetDirectBufferAddress(env, buffer);
+  CHECK_PTR(bytes, 0);
+  return deserialize(env, ctx, bytes + offset, length);
+}
+
+// A serialized value in transit between runtimes. Unlike serialize(), it may
+// reference SharedArrayBuffers, and holds a reference to each until freed.
+typedef struct {
+  uint8_t *data;
+  size_t len;
+  uint8_t **sab_tab;
+  size_t sab_count;
+} SharedMessage;
+
+static void free_shared_message(SharedMessage *msg) {
+  for (size_t i = 0; i < msg->sab_count; i++)
+    js_sab_free(NULL, msg->sab_tab[i]);
+  free(msg->sab_tab);
+  free(msg->data);
+  free(msg);
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_writeMessageInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *v = (JSValue *)valPtr;
+
+  size_t len, sab_count;
+  uint8_t **sab_tab;
+  uint8_t *buf =
+      JS_WriteObject2(ctx, &len, *v, SERIALIZE_FLAGS | JS_WRITE_OBJ_SAB,
+                      &sab_tab, &sab_count);
+  if (!buf) {
+    check_throw_exception(env, ctx, JS_EXCEPTION);
+    return 0;
+  }
+
+  // Copy out of the writer's heap: the message may outlive this runtime
+  SharedMessage *msg = calloc(1, sizeof(SharedMessage));
+  if (msg) {
+    msg->data = malloc(len > 0 ? len : 1);
+    msg->sab_tab = malloc(sizeof(uint8_t *) * (sab_count > 0 ? sab_count : 1));
+  }
+  if (!msg || !msg->data || !msg->sab_tab) {
+    if (msg) {
+      free(msg->data);
+      free(msg->sab_tab);
+      free(msg);
+    }
+    js_free(ctx, buf);
+    js_free(ctx, sab_tab);
+    JS_ThrowOutOfMemory(ctx);
+    check_throw_exception(env, ctx, JS_EXCEPTION);
+    return 0;
+  }
+  memcpy(msg->data, buf, len);
+  msg->len = len;
+  for (size_t i = 0; i < sab_count; i++) {
+    js_sab_dup(NULL, sab_tab[i]);
+    msg->sab_tab[i] = sab_tab[i];
+  }
+  msg->sab_count = sab_count;
+  js_free(ctx, buf);
+  js_free(ctx, sab_tab);
+  return (jlong)msg;
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_readMessageInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong messagePtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  SharedMessage *msg = (SharedMessage *)messagePtr;
+  CHECK_CONTEXT(ctx);
+  CHECK_PTR(msg, 0);
+
+  // The reader takes its own reference to each SharedArrayBuffer
+  JSValue val = JS_ReadObject(ctx, msg->data, msg->len,
+                              DESERIALIZE_FLAGS | JS_READ_OBJ_SAB);
+  check_throw_exception(env, ctx, val);
+  if (JS_IsException(val)) {
+    return 0;
+  }
+  return boxJSValue(val);
+}
+
+JNIEXPORT void JNICALL Java_com_quickjs_JSWorkerGroup_freeMessageInternal(
+    JNIEnv *env, jclass clazz, jlong messagePtr) {
+  SharedMessage *msg = (SharedMessage *)messagePtr;
+  if (msg)
+    free_shared_message(msg);
+}
+
+// Values are freed through the runtime, so a value whose context was
+// released first is still safe to free.
+JNIEXPORT void JNICALL Java_com_quickjs_JSReleaseQueue_freeValueInternal(
+    JNIEnv *env, jclass clazz, jlong runtimePtr, jlong valPtr) {
+  JSValue *v = (JSValue *)valPtr;
+  JS_FreeValueRT((JSRuntime *)runtimePtr, *v);
+  free(v);
+}
+
+// Frees the handles the Cleaner deferred to the owner thread in one call.
+JNIEXPORT void JNICALL Java_com_quickjs_JSReleaseQueue_releaseInternal(
+    JNIEnv *env, jclass clazz, jlong runtimePtr, jlongArray values,
+    jlongArray contexts) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  jsize value_count = (*env)->GetArrayLength(env, values);
+  if (value_count > 0) {
+    jlong *ptrs = (*env)->GetLongArrayElements(env, values, NULL);
+    if (!ptrs)
+      return;
+    for (jsize i = 0; i < value_count; i++) {
+      JSValue *v = (JSValue *)ptrs[i];
+      JS_FreeValueRT(rt, *v);
+      free(v);
+    }
+    (*env)->ReleaseLongArrayElements(env, values, ptrs, JNI_ABORT);
+  }
+  jsize context_count = (*env)->GetArrayLength(env, contexts);
+  if (context_count > 0) {
+    jlong *ptrs = (*env)->GetLongArrayElements(env, contexts, NULL);
+    if (!ptrs)
+      return;
+    for (jsize i = 0; i < context_count; i++)
+      free_context(env, (JSContext *)ptrs[i]);
+    (*env)->ReleaseLongArrayElements(env, contexts, ptrs, JNI_ABORT);
+  }
+}
+
+// Convert the pending Java exception into a thrown JS Error whose message is
+// the exception's toString().
+static JSValue throw_js_from_java_exception(JNIEnv *env, JSContext *ctx) {
+  jthrowable ex = (*env)->ExceptionOccurred(env);
+  (*env)->ExceptionClear(env);
+
+  jstring msg = (jstring)(*env)->CallObjectMethod(env, ex, g_Object_toString);
+  if ((*env)->ExceptionCheck(env)) {
+    (*env)->ExceptionClear(env);
+    msg = NULL;
+  }
+
+  // Fallback if toString fails
+  const char *c_msg = GetStringUTFChars(env, msg);
+
+  JSValue err = JS_NewError(ctx);
+  JS_DefinePropertyValueStr(
+      ctx, err, "message",
+      JS_NewString(ctx, c_msg ? c_msg : "Unknown Java Exception"),
+      JS_PROP_C_W_E);
+
+  if (msg) {
+    ReleaseStringUTFChars(env, msg, c_msg);
+    (*env)->DeleteLocalRef(env, msg);
+  }
+  (*env)->DeleteLocalRef(env, ex);
+
+  return JS_Throw(ctx, err);
+}
+
+// Convert a host callback's result, or its pending Java exception, to JS
+static JSValue finish_callback(JNIEnv *env, JSContext *ctx, jobject jResult) {
+  if ((*env)->ExceptionCheck(env)) {
+    return throw_js_from_java_exception(env, ctx);
+  }
+
+  if (jResult == NULL) {
+    return JS_UNDEFINED;
+  }
+
+  jlong resPtr = (*env)->GetLongField(env, jResult, g_JSValue_ptr);
+
+  JSValue *resValPtr = (JSValue *)resPtr;
+  JSValue resVal = JS_DupValue(ctx, *resValPtr);
+
+  (*env)->DeleteLocalRef(env, jResult);
+
+  return resVal;
+}
+
+// finish_callback with the call timed as OP_HOST_CALLBACK, tagged with the
+// callback's name and the calling script
+static JSValue record_callback_metric(JNIEnv *env, JSContext *ctx,
+                                      NativeRuntimeData *data,
+                                      JSValueConst name, int64_t start,
+                                      jobject jResult) {
+  JSValue result = finish_callback(env, ctx, jResult);
+  const char *c_name = JS_ToCString(ctx, name);
+  JSAtom file_atom = JS_GetScriptOrModuleName(ctx, 1);
+  const char *c_file =
+      file_atom != JS_ATOM_NULL ? JS_AtomToCString(ctx, file_atom) : NULL;
+  record_metric(env, data, OP_HOST_CALLBACK, c_file, c_name, start);
+  JS_FreeCString(ctx, c_file);
+  JS_FreeAtom(ctx, file_atom);
+  JS_FreeCString(ctx, c_name);
+  return result;
+}
+
+static JSValue callback_trampoline(JSContext *ctx, JSValueConst this_val,
+                                   int argc, JSValueConst *argv, int magic,
+                                   JSValue *func_data) {
+  JSValue proxy = func_data[0];
+  jobject javaCallback = (jobject)JS_GetOpaque(proxy, js_java_proxy_class_id);
+  if (!javaCallback)
+    return JS_UNDEFINED;
+
+  NativeContextData *cd = get_context_data(ctx);
+  if (!cd || !cd->javaContext)
+    return JS_UNDEFINED;
+
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+    return JS_ThrowInternalError(ctx, "JNI Env unavailable");
+  }
+
+  jobject javaContext = (*env)->NewLocalRef(env, cd->javaContext);
+  if (!javaContext) {
+    return JS_ThrowInternalError(ctx, "Java JSContext is dead");
+  }
+
+  // Use cached classes and methods
+  jlong thisPtr = boxJSValue(JS_DupValue(ctx, this_val));
+  if (thisPtr == 0)
+    return JS_ThrowInternalError(ctx, "Native Error: OOM in boxJSValue");
+
+  jobject jThis = (*env)->NewObject(env, g_JSValueClass, g_JSValue_ctor,
+                                    thisPtr, javaContext);
+  if (!jThis) {
+    free((void *)thisPtr);
+    return JS_ThrowInternalError(ctx,
+                                 "JNI Error: Failed to create 'this' JSValue");
+  }
+
+  jobjectArray jArgs = (*env)->NewObjectArray(env, argc, g_JSValueClass, NULL);
+  if (!jArgs) {
+    (*env)->DeleteLocalRef(env, jThis);
+    return JS_ThrowInternalError(ctx,
+                                 "JNI Error: Failed to create argument array");
+  }
+
+  for (int i = 0; i < argc; i++) {
+    jlong argPtr = boxJSValue(JS_DupValue(ctx, argv[i]));
+    if (argPtr == 0) {
+      (*env)->DeleteLocalRef(env, jThis);
+      (*env)->DeleteLocalRef(env, jArgs);
+      return JS_ThrowInternalError(ctx, "Native Error: OOM in argument boxing");
+    }
+    jobject jArg = (*env)->NewObject(env, g_JSValueClass, g_JSValue_ctor,
+                                     argPtr, javaContext);
+    if (!jArg) {
+      free((void *)argPtr);
+      (*env)->DeleteLocalRef(env, jThis);
+      (*env)->DeleteLocalRef(env, jArgs);
+      return JS_ThrowInternalError(
+          ctx, "JNI Error: Failed to create argument JSValue");
+    }
+    (*env)->SetObjectArrayElement(env, jArgs, i, jArg);
+    (*env)->DeleteLocalRef(env, jArg);
+  }
+
+  NativeRuntimeData *data = get_runtime_data(ctx);
+  int64_t start = data->metrics ? monotonic_ns() : 0;
+
+  jobject jResult = (*env)->CallObjectMethod(
+      env, javaCallback, g_JSFunction_apply, javaContext, jThis, jArgs);
+
+  (*env)->DeleteLocalRef(env, javaContext);
+  (*env)->DeleteLocalRef(env, jThis);
+  (*env)->DeleteLocalRef(env, jArgs);
+
+  if (data->metrics) {
+    return record_callback_metric(env, ctx, data, func_data[1], start,
+                                  jResult);
+  }
+  return finish_callback(env, ctx, jResult);
+}
+
+// A JS function that calls callback.apply. The function keeps its own global
+// ref to callback, released by the proxy's finalizer.
+static JSValue new_java_function(JNIEnv *env, JSContext *ctx, jobject callback,
+                                 const char *name, int argCount) {
+  jobject cbGlobal = (*env)->NewGlobalRef(env, callback);
+
+  JSValue proxy = JS_NewObjectClass(ctx, js_java_proxy_class_id);
+  JS_SetOpaque(proxy, cbGlobal);
+
+  // func_data[1] keeps the name for metrics tags
+  JSValue func_data[2];
+  func_data[0] = proxy;
+  func_data[1] = JS_NewString(ctx, name);
+
+  JSValue func =
+      JS_NewCFunctionData(ctx, callback_trampoline, argCount, 0, 2, func_data);
+  JS_DefinePropertyValueStr(ctx, func, "name", JS_DupValue(ctx, func_data[1]),
+                            JS_PROP_CONFIGURABLE);
+
+  JS_FreeValue(ctx, proxy);
+  JS_FreeValue(ctx, func_data[1]);
+  return func;
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_createFunctionInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jobject callback, jstring name,
+    jint argCount) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  if (!ctx)
+    return 0;
+
+  const char *c_name = GetStringUTFChars(env, name);
+  JSValue func = new_java_function(env, ctx, callback, c_name, argCount);
+  ReleaseStringUTFChars(env, name, c_name);
+
+  return boxJSValue(func);
+}
+
+// --- Host modules ---
+//
+// A host module is a table of Java functions that scripts import by name,
+// e.g. `import { query } from 'host:db'`. The table is registered once per
+// runtime; the JS functions are only created when a context first links the
+// module, so contexts that never import it pay nothing.
+
+typedef struct HostModule {
+  char *name;
+  int export_count;
+  char **export_names;
+  jobject *functions; // global refs to the JSFunction of each export
+} HostModule;
+
+static void free_host_module(JNIEnv *env, HostModule *mod) {
+  if (!mod)
+    return;
+  for (int i = 0; i < mod->export_count; i++) {
+    free(mod->export_names[i]);
+    if (mod->functions[i])
+      (*env)->DeleteGlobalRef(env, mod->functions[i]);
+  }
+  free(mod->export_names);
+  free(mod->functions);
+  free(mod->name);
+  free(mod);
+}
+
+static void free_host_modules(JNIEnv *env, NativeRuntimeData *data) {
+  for (int i = 0; i < data->host_module_count; i++) {
+    free_host_module(env, data->host_modules[i]);
+  }
+  free(data->host_modules);
+  data->host_modules = NULL;
+  data->host_module_count = 0;
+}
+
+static HostModule *find_host_module(NativeRuntimeData *data,
+                                    const char *name) {
+  for (int i = 0; i < data->host_module_count; i++) {
+    if (strcmp(data->host_modules[i]->name, name) == 0)
+      return data->host_modules[i];
+  }
+  return NULL;
+}
+
+// Runs when a context links the module: binds each export to a new function
+static int host_module_init(JSContext *ctx, JSModuleDef *m) {
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+    JS_ThrowInternalError(ctx, "JNI Env unavailable");
+    return -1;
+  }
+  JSAtom atom = JS_GetModuleName(ctx, m);
+  const char *name = JS_AtomToCString(ctx, atom);
+  JS_FreeAtom(ctx, atom);
+  if (!name)
+    return -1;
+  HostModule *mod = find_host_module(get_runtime_data(ctx), name);
+  JS_FreeCString(ctx, name);
+  if (!mod) {
+    JS_ThrowInternalError(ctx, "host module is not registered");
+    return -1;
+  }
+
+  for (int i = 0; i < mod->export_count; i++) {
+    JSValue func = new_java_function(env, ctx, mod->functions[i],
+                                     mod->export_names[i], 0);
+    if (JS_IsException(func) ||
+        JS_SetModuleExport(ctx, m, mod->export_names[i], func) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+static JSModuleDef *load_host_module(JSContext *ctx, HostModule *mod) {
+  JSModuleDef *m = JS_NewCModule(ctx, mod->name, host_module_init);
+  if (!m)
+    return NULL;
+  for (int i = 0; i < mod->export_count; i++) {
+    if (JS_AddModuleExport(ctx, m, mod->export_names[i]) < 0)
+      return NULL;
+  }
+  return m;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_quickjs_JSRuntime_registerHostModuleInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jstring name,
+    jobjectArray exportNames, jobjectArray functions) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  CHECK_RUNTIME(rt);
+  NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
+
+  HostModule **modules =
+      realloc(data->host_modules,
+              sizeof(HostModule *) * (data->host_module_count + 1));
+  if (!modules)
+    return JNI_FALSE;
+  data->host_modules = modules;
+
+  int count = (*env)->GetArrayLength(env, exportNames);
+  HostModule *mod = calloc(1, sizeof(HostModule));
+  if (!mod)
+    return JNI_FALSE;
+  const char *c_name = GetStringUTFChars(env, name);
+  mod->name = c_name ? strdup(c_name) : NULL;
+  ReleaseStringUTFChars(env, name, c_name);
+  mod->export_names = calloc(count > 0 ? count : 1, sizeof(char *));
+  mod->functions = calloc(count > 0 ? count : 1, sizeof(jobject));
+  if (!mod->name || !mod->export_names || !mod->functions) {
+    free_host_module(env, mod);
+    return JNI_FALSE;
+  }
+
+  for (int i = 0; i < count; i++) {
+    mod->export_count = i + 1;
+    jstring exportName = (*env)->GetObjectArrayElement(env, exportNames, i);
+    jobject function = (*env)->GetObjectArrayElement(env, functions, i);
+    const char *c_export = GetStringUTFChars(env, exportName);
+    mod->export_names[i] = c_export ? strdup(c_export) : NULL;
+    mod->functions[i] = (*env)->NewGlobalRef(env, function);
+    ReleaseStringUTFChars(env, exportName, c_export);
+    (*env)->DeleteLocalRef(env, exportName);
+    (*env)->DeleteLocalRef(env, function);
+    if (!mod->export_names[i] || !mod->functions[i]) {
+      free_host_module(env, mod);
+      return JNI_FALSE;
+    }
+  }
+
+  data->host_modules[data->host_module_count++] = mod;
+  // Host modules resolve even when no JSModuleLoader is set
+  JS_SetModuleLoaderFunc(rt, NULL, js_java_module_loader, data);
+  return JNI_TRUE;
+}
+
+// --- Shared frozen values ---
+//
+// JSRuntime.shareFrozen() copies a value into a context private to the
+// runtime, deep-freezes the copy and defines it on the global object of
+// every context. Objects belong to the runtime rather than a context, so
+// each context references the same object graph, and freezing makes it safe
+// to share. Freezing takes in the prototypes, i.e. the private context's
+// built-ins, which no script ever runs against; the contexts scripts use
+// keep theirs writable. The runtime holds its own reference, so the graph
+// outlives the context it was created in.
+
+typedef struct SharedValue {
+  char *name;
+  JSValue value;
+} SharedValue;
+
+static void free_shared_values(JSRuntime *rt, NativeRuntimeData *data) {
+  for (int i = 0; i < data->shared_count; i++) {
+    free(data->shared[i].name);
+    JS_FreeValueRT(rt, data->shared[i].value);
+  }
+  free(data->shared);
+  data->shared = NULL;
+  data->shared_count = 0;
+  if (data->shared_ctx) {
+    JS_FreeContext(data->shared_ctx);
+    data->shared_ctx = NULL;
+  }
+}
+
+// Objects deep_freeze has visited, by address. Open addressing.
+typedef struct {
+  void **slots;
+  size_t capacity; // power of two
+  size_t size;
+} FreezeSeen;
+
+// Objects still to be frozen, each holding a reference.
+typedef struct {
+  JSValue *items;
+  size_t capacity;
+  size_t size;
+} FreezeStack;
+
+static size_t freeze_hash(void *p) {
+  uint64_t x = (uint64_t)(uintptr_t)p;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL; // murmur3 finalizer
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+static int freeze_seen_grow(FreezeSeen *seen) {
+  size_t new_capacity = seen->capacity ? seen->capacity * 2 : 64;
+  void **slots = calloc(new_capacity, sizeof(void *));
+  if (!slots)
+    return -1;
+  for (size_t i = 0; i < seen->capacity; i++) {
+    void *p = seen->slots[i];
+    if (!p)
+      continue;
+    size_t j = freeze_hash(p) & (new_capacity - 1);
+    while (slots[j])
+      j = (j + 1) & (new_capacity - 1);
+    slots[j] = p;
+  }
+  free(seen->slots);
+  seen->slots = slots;
+  seen->capacity = new_capacity;
+  return 0;
+}
+
+// 1 if p was added, 0 if it was already present, -1 on OOM.
+static int freeze_seen_add(FreezeSeen *seen, void *p) {
+  if (seen->size * 2 >= seen->capacity && freeze_seen_grow(seen) < 0)
+    return -1;
+  size_t i = freeze_hash(p) & (seen->capacity - 1);
+  while (seen->slots[i]) {
+    if (seen->slots[i] == p)
+      return 0;
+    i = (i + 1) & (seen->capacity - 1);
+  }
+  seen->slots[i] = p;
+  seen->size++;
+  return 1;
+}
+
+// Takes ownership of val, freeing it on OOM.
+static int freeze_stack_push(JSContext *ctx, FreezeStack *stack, JSValue val) {
+  if (stack->size == stack->capacity) {
+    size_t new_capacity = stack->capacity ? stack->capacity * 2 : 64;
+    JSValue *items = realloc(stack->items, new_capacity * sizeof(JSValue));
+    if (!items) {
+      JS_FreeValue(ctx, val);
+      JS_ThrowOutOfMemory(ctx);
+      return -1;
+    }
+    stack->items = items;
+    stack->capacity = new_capacity;
+  }
+  stack->items[stack->size++] = val;
+  return 0;
+}
+
+// Object.freeze(obj), queueing its prototype and the objects held by its
+// data properties. Accessors are made non-configurable but never called.
+static int freeze_object(JSContext *ctx, JSValueConst obj,
+                         FreezeStack *pending) {
+  if (JS_PreventExtensions(ctx, obj) < 0)
+    return -1;
+  // Prototypes are shared too: left writable, any context could replace
+  // e.g. Array.prototype.map under every other context's feet
+  JSValue proto = JS_GetPrototype(ctx, obj);
+  if (JS_IsException(proto))
+    return -1;
+  if (JS_IsObject(proto)) {
+    if (freeze_stack_push(ctx, pending, proto) < 0)
+      return -1;
+  } else {
+    JS_FreeValue(ctx, proto);
+  }
+  JSPropertyEnum *tab;
+  uint32_t len;
+  if (JS_GetOwnPropertyNames(ctx, &tab, &len, obj,
+                             JS_GPN_STRING_MASK | JS_GPN_SYMBOL_MASK) < 0)
+    return -1;
+
+  int ret = 0;
+  for (uint32_t i = 0; i < len && ret == 0; i++) {
+    JSPropertyDescriptor desc;
+    int found = JS_GetOwnProperty(ctx, &desc, obj, tab[i].atom);
+    if (found < 0) {
+      ret = -1;
+      break;
+    }
+    if (!found)
+      continue;
+    int flags = JS_PROP_HAS_CONFIGURABLE | JS_PROP_THROW;
+    if (!(desc.flags & JS_PROP_GETSET)) {
+      flags |= JS_PROP_HAS_WRITABLE;
+      if (JS_IsObject(desc.value) &&
+          freeze_stack_push(ctx, pending, JS_DupValue(ctx, desc.value)) < 0)
+        ret = -1;
+    }
+    // Typed arrays refuse this for their elements, as with Object.freeze
+    if (ret == 0 && JS_DefineProperty(ctx, obj, tab[i].atom, JS_UNDEFINED,
+                                      JS_UNDEFINED, JS_UNDEFINED, flags) < 0)
+      ret = -1;
+    JS_FreeValue(ctx, desc.value);
+    JS_FreeValue(ctx, desc.getter);
+    JS_FreeValue(ctx, desc.setter);
+  }
+  JS_FreePropertyEnum(ctx, tab, len);
+  return ret;
+}
+
+// Freeze root and every object reachable from it through data properties
+// and prototypes, which takes in the intrinsics of the context that created
+// it, so only used on the runtime's private shared context. Iterative, so
+// deeply nested data cannot overflow the C stack.
+static int deep_freeze(JSContext *ctx, JSValueConst root) {
+  if (!JS_IsObject(root))
+    return 0;
+  FreezeSeen seen = {0};
+  FreezeStack pending = {0};
+  int ret = freeze_stack_push(ctx, &pending, JS_DupValue(ctx, root));
+  while (ret == 0 && pending.size > 0) {
+    JSValue obj = pending.items[--pending.size];
+    int added = freeze_seen_add(&seen, JS_VALUE_GET_PTR(obj));
+    if (added < 0) {
+      JS_ThrowOutOfMemory(ctx);
+      ret = -1;
+    } else if (added > 0) {
+      ret = freeze_object(ctx, obj, &pending);
+    }
+    JS_FreeValue(ctx, obj);
+  }
+  while (pending.size > 0)
+    JS_FreeValue(ctx, pending.items[--pending.size]);
+  free(pending.items);
+  free(seen.slots);
+  return ret;
+}
+
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_shareFrozenInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jstring name, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *val = (JSValue *)valPtr;
+  if (!ctx || !val)
+    return;
+  NativeRuntimeData *data = get_runtime_data(ctx);
+
+  if (!data->shared_ctx)
+    data->shared_ctx = JS_NewContext(data->rt);
+  JSContext *shared_ctx = data->shared_ctx;
+  if (!shared_ctx) {
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in shareFrozen");
+    return;
+  }
+  size_t size;
+  uint8_t *buf = JS_WriteObject(ctx, &size, *val, SERIALIZE_FLAGS);
+  if (!buf) {
+    check_throw_exception(env, ctx, JS_EXCEPTION);
+    return;
+  }
+  JSValue copy = JS_ReadObject(shared_ctx, buf, size, DESERIALIZE_FLAGS);
+  js_free(ctx, buf);
+  if (JS_IsException(copy) || deep_freeze(shared_ctx, copy) < 0) {
+    JS_FreeValue(shared_ctx, copy);
+    check_throw_exception(env, shared_ctx, JS_EXCEPTION);
+    return;
+  }
+
+  SharedValue *shared =
+      realloc(data->shared, sizeof(SharedValue) * (data->shared_count + 1));
+  if (!shared) {
+    JS_FreeValue(shared_ctx, copy);
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in shareFrozen");
+    return;
+  }
+  data->shared = shared;
+  const char *c_name = GetStringUTFChars(env, name);
+  char *name_copy = c_name ? strdup(c_name) : NULL;
+  ReleaseStringUTFChars(env, name, c_name);
+  if (!name_copy) {
+    JS_FreeValue(shared_ctx, copy);
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in shareFrozen");
+    return;
+  }
+  shared[data->shared_count].name = name_copy;
+  shared[data->shared_count].value = copy;
+  data->shared_count++;
+}
+
+// Whether installSharedInternal can define name on the context's global:
+// not if a non-configurable property of that name, such as undefined or a
+// var, is in the way, or if the global object is not extensible.
+JNIEXPORT jboolean JNICALL Java_com_quickjs_JSRuntime_canShareInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jstring name) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  if (!ctx)
+    return JNI_FALSE;
+  const char *c_name = GetStringUTFChars(env, name);
+  CHECK_PTR(c_name, JNI_FALSE);
+  JSAtom atom = JS_NewAtom(ctx, c_name);
+  ReleaseStringUTFChars(env, name, c_name);
+
+  JSValue global = JS_GetGlobalObject(ctx);
+  JSPropertyDescriptor desc;
+  int found = JS_GetOwnProperty(ctx, &desc, global, atom);
+  int ok;
+  if (found > 0) {
+    ok = (desc.flags & JS_PROP_CONFIGURABLE) != 0;
+    JS_FreeValue(ctx, desc.value);
+    JS_FreeValue(ctx, desc.getter);
+    JS_FreeValue(ctx, desc.setter);
+  } else {
+    ok = found == 0 && JS_IsExtensible(ctx, global) > 0;
+  }
+  if (JS_HasException(ctx))
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  JS_FreeValue(ctx, global);
+  JS_FreeAtom(ctx, atom);
+  return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+// Define the shared values from index first on on the context's global
+// object, read-only and non-deletable.
+JNIEXPORT void JNICALL Java_com_quickjs_JSRuntime_installSharedInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jint first) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  if (!ctx)
+    return;
+  NativeRuntimeData *data = get_runtime_data(ctx);
+
+  JSValue global = JS_GetGlobalObject(ctx);
+  for (int i = first; i < data->shared_count; i++) {
+    SharedValue *shared = &data->shared[i];
+    if (JS_DefinePropertyValueStr(ctx, global, shared->name,
+                                  JS_DupValue(ctx, shared->value),
+                                  JS_PROP_ENUMERABLE | JS_PROP_THROW) < 0) {
+      check_throw_exception(env, ctx, JS_EXCEPTION);
+      break;
+    }
+  }
+  JS_FreeValue(ctx, global);
+}
+
+// --- Java collection views ---
+//
+// A view is an exotic JS object whose properties read and write through to a
+// java.util.Map or java.util.List on access, so exposing a large collection
+// costs nothing up front. Nested collections become views themselves, with
+// the same writability as their parent.
+
+typedef struct {
+  jobject target; // global ref to the Map or List
+  int writable;
+} JavaView;
+
+static JSClassID js_java_map_class_id;
+static JSClassID js_java_list_class_id;
+
+static JavaView *get_java_view(JSValueConst obj) {
+  JavaView *view = JS_GetOpaque(obj, js_java_map_class_id);
+  return view ? view : JS_GetOpaque(obj, js_java_list_class_id);
+}
+
+static void js_java_view_finalizer(JSRuntime *rt, JSValue val) {
+  JavaView *view = get_java_view(val);
+  if (!view)
+    return;
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) == JNI_OK) {
+    (*env)->DeleteGlobalRef(env, view->target);
+  }
+  free(view);
+}
+
+static JSValue new_java_view(JNIEnv *env, JSContext *ctx, jobject target,
+                             int writable);
+
+// Convert a Java element to JS. Consumes the local ref to obj.
+static JSValue java_to_js(JNIEnv *env, JSContext *ctx, jobject obj,
+                          int writable) {
+  JSValue result;
+  if (!obj) {
+    return JS_NULL;
+  } else if ((*env)->IsInstanceOf(env, obj, g_StringClass)) {
+    const char *str = GetStringUTFChars(env, (jstring)obj);
+    result = str ? JS_NewString(ctx, str) : JS_ThrowOutOfMemory(ctx);
+    ReleaseStringUTFChars(env, (jstring)obj, str);
+  } else if ((*env)->IsInstanceOf(env, obj, g_BooleanClass)) {
+    result = JS_NewBool(
+        ctx, (*env)->CallBooleanMethod(env, obj, g_Boolean_booleanValue));
+  } else if ((*env)->IsInstanceOf(env, obj, g_IntegerClass)) {
+    result =
+        JS_NewInt32(ctx, (*env)->CallIntMethod(env, obj, g_Number_intValue));
+  } else if ((*env)->IsInstanceOf(env, obj, g_LongClass)) {
+    result =
+        JS_NewInt64(ctx, (*env)->CallLongMethod(env, obj, g_Number_longValue));
+  } else if ((*env)->IsInstanceOf(env, obj, g_NumberClass)) {
+    result = JS_NewFloat64(
+        ctx, (*env)->CallDoubleMethod(env, obj, g_Number_doubleValue));
+  } else if ((*env)->IsInstanceOf(env, obj, g_MapClass) ||
+             (*env)->IsInstanceOf(env, obj, g_ListClass)) {
+    result = new_java_view(env, ctx, obj, writable);
+  } else {
+    result =
+        JS_ThrowTypeError(ctx, "unsupported Java type in collection view");
+  }
+  (*env)->DeleteLocalRef(env, obj);
+  // e.g. a Number subclass whose doubleValue() threw
+  if ((*env)->ExceptionCheck(env)) {
+    JS_FreeValue(ctx, result);
+    return throw_js_from_java_exception(env, ctx);
+  }
+  return result;
+}
+
+// Convert a JS value to a Java element. Returns -1 with a pending JS
+// exception on failure.
+static int js_to_java(JNIEnv *env, JSContext *ctx, JSValueConst val,
+                      jobject *out) {
+  *out = NULL;
+  int tag = JS_VALUE_GET_TAG(val);
+  if (tag == JS_TAG_NULL || tag == JS_TAG_UNDEFINED)
+    return 0;
+  if (tag == JS_TAG_BOOL) {
+    *out = (*env)->CallStaticObjectMethod(env, g_BooleanClass,
+                                          g_Boolean_valueOf, JS_ToBool(ctx, val));
+  } else if (tag == JS_TAG_INT) {
+    *out = (*env)->CallStaticObjectMethod(env, g_IntegerClass,
+                                          g_Integer_valueOf,
+                                          JS_VALUE_GET_INT(val));
+  } else if (JS_IsNumber(val)) {
+    double d;
+    JS_ToFloat64(ctx, &d, val);
+    *out = (*env)->CallStaticObjectMethod(env, g_DoubleClass, g_Double_valueOf,
+                                          d);
+  } else if (JS_IsString(val)) {
+    const char *str = JS_ToCString(ctx, val);
+    if (!str)
+      return -1;
+    *out = (*env)->NewStringUTF(env, str);
+    JS_FreeCString(ctx, str);
+  } else {
+    JavaView *view = get_java_view(val);
+    if (!view) {
+      JS_ThrowTypeError(ctx, "cannot store this value in a Java collection");
+      return -1;
+    }
+    *out = (*env)->NewLocalRef(env, view->target);
+  }
+  if ((*env)->ExceptionCheck(env)) {
+    throw_js_from_java_exception(env, ctx);
+    return -1;
+  }
+  return 0;
+}
+
+// Index of an integer atom, or -1 for any other property key
+static int64_t view_atom_index(JSContext *ctx, JSAtom atom) {
+  JSValue key = JS_AtomToValue(ctx, atom);
+  int64_t idx = JS_VALUE_GET_TAG(key) == JS_TAG_INT ? JS_VALUE_GET_INT(key) : -1;
+  JS_FreeValue(ctx, key);
+  return idx;
+}
+
+// Java String for a map key atom, or NULL (without an exception) for symbols
+static jstring view_map_key(JNIEnv *env, JSContext *ctx, JSAtom atom) {
+  JSValue key = JS_AtomToValue(ctx, atom);
+  if (JS_IsSymbol(key)) {
+    JS_FreeValue(ctx, key);
+    return NULL;
+  }
+  JS_FreeValue(ctx, key);
+  const char *str = JS_AtomToCString(ctx, atom);
+  if (!str)
+    return NULL;
+  jstring jkey = (*env)->NewStringUTF(env, str);
+  JS_FreeCString(ctx, str);
+  return jkey;
+}
+
+static int view_is_length(JSContext *ctx, JSAtom atom) {
+  const char *str = JS_AtomToCString(ctx, atom);
+  int is_length = str && strcmp(str, "length") == 0;
+  JS_FreeCString(ctx, str);
+  return is_length;
+}
+
+static JNIEnv *view_env(JSContext *ctx) {
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+    JS_ThrowInternalError(ctx, "JNI Env unavailable");
+    return NULL;
+  }
+  return env;
+}
+
+static int js_java_view_get_own_property(JSContext *ctx,
+                                         JSPropertyDescriptor *desc,
+                                         JSValueConst obj, JSAtom prop) {
+  JavaView *view = get_java_view(obj);
+  JNIEnv *env = view_env(ctx);
+  if (!env)
+    return -1;
+  int flags = view->writable ? JS_PROP_C_W_E : JS_PROP_ENUMERABLE;
+  JSValue value;
+
+  if (JS_GetClassID(obj) == js_java_list_class_id) {
+    jint size = (*env)->CallIntMethod(env, view->target, g_List_size);
+    if ((*env)->ExceptionCheck(env)) {
+      throw_js_from_java_exception(env, ctx);
+      return -1;
+    }
+    int64_t idx = view_atom_index(ctx, prop);
+    if (idx < 0) {
+      if (!view_is_length(ctx, prop))
+        return 0;
+      flags &= JS_PROP_WRITABLE;
+      value = JS_NewInt32(ctx, size);
+    } else {
+      if (idx >= size)
+        return 0;
+      if (!desc)
+        return 1;
+      jobject elem =
+          (*env)->CallObjectMethod(env, view->target, g_List_get, (jint)idx);
+      if ((*env)->ExceptionCheck(env)) {
+        throw_js_from_java_exception(env, ctx);
+        return -1;
+      }
+      value = java_to_js(env, ctx, elem, view->writable);
+    }
+  } else {
+    jstring key = view_map_key(env, ctx, prop);
+    if (!key)
+      return 0;
+    if (!desc) {
+      jboolean found = (*env)->CallBooleanMethod(env, view->target,
+                                                 g_Map_containsKey, key);
+      (*env)->DeleteLocalRef(env, key);
+      if ((*env)->ExceptionCheck(env)) {
+        throw_js_from_java_exception(env, ctx);
+        return -1;
+      }
+      return found;
+    }
+    jobject elem = (*env)->CallObjectMethod(env, view->target, g_Map_get, key);
+    if ((*env)->ExceptionCheck(env)) {
+      (*env)->DeleteLocalRef(env, key);
+      throw_js_from_java_exception(env, ctx);
+      return -1;
+    }
+    // A null value may still be a present key
+    jboolean found = elem || (*env)->CallBooleanMethod(env, view->target,
+                                                       g_Map_containsKey, key);
+    (*env)->DeleteLocalRef(env, key);
+    if ((*env)->ExceptionCheck(env)) {
+      throw_js_from_java_exception(env, ctx);
+      return -1;
+    }
+    if (!found)
+      return 0;
+    value = java_to_js(env, ctx, elem, view->writable);
+  }
+
+  if (JS_IsException(value))
+    return -1;
+  if (desc) {
+    desc->flags = flags;
+    desc->value = value;
+    desc->getter = JS_UNDEFINED;
+    desc->setter = JS_UNDEFINED;
+  } else {
+    JS_FreeValue(ctx, value);
+  }
+  return 1;
+}
+
+static int js_java_view_get_own_property_names(JSContext *ctx,
+                                               JSPropertyEnum **ptab,
+                                               uint32_t *plen,
+                                               JSValueConst obj) {
+  JavaView *view = get_java_view(obj);
+  JNIEnv *env = view_env(ctx);
+  if (!env)
+    return -1;
+  int is_list = JS_GetClassID(obj) == js_java_list_class_id;
+
+  jobjectArray keys = NULL;
+  jint count;
+  if (is_list) {
+    count = (*env)->CallIntMethod(env, view->target, g_List_size);
+  } else {
+    jobject keySet = (*env)->CallObjectMethod(env, view->target, g_Map_keySet);
+    if (keySet) {
+      keys = (*env)->CallObjectMethod(env, keySet, g_Collection_toArray);
+      (*env)->DeleteLocalRef(env, keySet);
+    }
+    count = keys ? (*env)->GetArrayLength(env, keys) : 0;
+  }
+  if ((*env)->ExceptionCheck(env)) {
+    if (keys)
+      (*env)->DeleteLocalRef(env, keys);
+    throw_js_from_java_exception(env, ctx);
+    return -1;
+  }
+
+  // Lists also report their non-enumerable length
+  JSPropertyEnum *tab =
+      js_malloc(ctx, sizeof(JSPropertyEnum) * ((size_t)count + 1));
+  if (!tab) {
+    if (keys)
+      (*env)->DeleteLocalRef(env, keys);
+    return -1;
+  }
+  uint32_t len = 0;
+  for (jint i = 0; i < count; i++) {
+    JSAtom atom;
+    if (is_list) {
+      atom = JS_NewAtomUInt32(ctx, (uint32_t)i);
+    } else {
+      jobject key = (*env)->GetObjectArrayElement(env, keys, i);
+      if (!key || !(*env)->IsInstanceOf(env, key, g_StringClass)) {
+        (*env)->DeleteLocalRef(env, key);
+        continue;
+      }
+      const char *str = GetStringUTFChars(env, (jstring)key);
+      atom = str ? JS_NewAtom(ctx, str) : JS_ATOM_NULL;
+      ReleaseStringUTFChars(env, (jstring)key, str);
+      (*env)->DeleteLocalRef(env, key);
+    }
+    if (atom == JS_ATOM_NULL) {
+      JS_FreePropertyEnum(ctx, tab, len);
+      if (keys)
+        (*env)->DeleteLocalRef(env, keys);
+      return -1;
+    }
+    tab[len].is_enumerable = 1;
+    tab[len].atom = atom;
+    len++;
+  }
+  if (is_list) {
+    tab[len].is_enumerable = 0;
+    tab[len].atom = JS_NewAtom(ctx, "length");
+    len++;
+  }
+  if (keys)
+    (*env)->DeleteLocalRef(env, keys);
+
+  *ptab = tab;
+  *plen = len;
+  return 0;
+}
+
+// Store val under prop. Returns 1 on success, -1 with a pending exception.
+static int java_view_store(JSContext *ctx, JSValueConst obj, JSAtom prop,
+                           JSValueConst val) {
+  JavaView *view = get_java_view(obj);
+  if (!view->writable) {
+    JS_ThrowTypeError(ctx, "Java collection view is read-only");
+    return -1;
+  }
+  JNIEnv *env = view_env(ctx);
+  if (!env)
+    return -1;
+
+  if (JS_GetClassID(obj) == js_java_list_class_id) {
+    jint size = (*env)->CallIntMethod(env, view->target, g_List_size);
+    if ((*env)->ExceptionCheck(env)) {
+      throw_js_from_java_exception(env, ctx);
+      return -1;
+    }
+    int64_t idx = view_atom_index(ctx, prop);
+    if (idx < 0) {
+      uint32_t new_len;
+      if (!view_is_length(ctx, prop)) {
+        JS_ThrowTypeError(ctx, "Java list views only accept index keys");
+        return -1;
+      }
+      // Array.prototype.push writes length after appending; accept that.
+      if (JS_ToUint32(ctx, &new_len, val) < 0)
+        return -1;
+      if (new_len != (uint32_t)size) {
+        JS_ThrowRangeError(ctx, "cannot resize a Java list view");
+        return -1;
+      }
+      return 1;
+    }
+    if (idx > size) {
+      JS_ThrowRangeError(ctx, "Java list view index out of bounds");
+      return -1;
+    }
+    jobject elem;
+    if (js_to_java(env, ctx, val, &elem) < 0)
+      return -1;
+    if (idx == size) {
+      (*env)->CallBooleanMethod(env, view->target, g_List_add, elem);
+    } else {
+      jobject old = (*env)->CallObjectMethod(env, view->target, g_List_set,
+                                             (jint)idx, elem);
+      (*env)->DeleteLocalRef(env, old);
+    }
+    (*env)->DeleteLocalRef(env, elem);
+  } else {
+    jstring key = view_map_key(env, ctx, prop);
+    if (!key) {
+      JS_ThrowTypeError(ctx, "Java map views only accept string keys");
+      return -1;
+    }
+    jobject elem;
+    if (js_to_java(env, ctx, val, &elem) < 0) {
+      (*env)->DeleteLocalRef(env, key);
+      return -1;
+    }
+    jobject old =
+        (*env)->CallObjectMethod(env, view->target, g_Map_put, key, elem);
+    (*env)->DeleteLocalRef(env, old);
+    (*env)->DeleteLocalRef(env, elem);
+    (*env)->DeleteLocalRef(env, key);
+  }
+
+  if ((*env)->ExceptionCheck(env)) {
+    throw_js_from_java_exception(env, ctx);
+    return -1;
+  }
+  return 1;
+}
+
+static int js_java_view_set_property(JSContext *ctx, JSValueConst obj,
+                                     JSAtom prop, JSValueConst val,
+                                     JSValueConst receiver, int flags) {
+  return java_view_store(ctx, obj, prop, val);
+}
+
+static int js_java_view_define_own_property(JSContext *ctx,
+                                            JSValueConst this_obj, JSAtom prop,
+                                            JSValueConst val,
+                                            JSValueConst getter,
+                                            JSValueConst setter, int flags) {
+  if (flags & (JS_PROP_HAS_GET | JS_PROP_HAS_SET)) {
+    JS_ThrowTypeError(ctx, "Java collection views cannot hold accessors");
+    return -1;
+  }
+  if (!(flags & JS_PROP_HAS_VALUE))
+    return 1;
+  return java_view_store(ctx, this_obj, prop, val);
+}
+
+static int js_java_view_delete_property(JSContext *ctx, JSValueConst obj,
+                                        JSAtom prop) {
+  JavaView *view = get_java_view(obj);
+  if (JS_GetClassID(obj) == js_java_list_class_id) {
+    JS_ThrowTypeError(ctx, "cannot delete from a Java list view");
+    return -1;
+  }
+  if (!view->writable) {
+    JS_ThrowTypeError(ctx, "Java collection view is read-only");
+    return -1;
+  }
+  JNIEnv *env = view_env(ctx);
+  if (!env)
+    return -1;
+  jstring key = view_map_key(env, ctx, prop);
+  if (!key)
+    return 1;
+  jobject old = (*env)->CallObjectMethod(env, view->target, g_Map_remove, key);
+  (*env)->DeleteLocalRef(env, old);
+  (*env)->DeleteLocalRef(env, key);
+  if ((*env)->ExceptionCheck(env)) {
+    throw_js_from_java_exception(env, ctx);
+    return -1;
+  }
+  return 1;
+}
+
+static JSClassExoticMethods js_java_view_exotic = {
+    .get_own_property = js_java_view_get_own_property,
+    .get_own_property_names = js_java_view_get_own_property_names,
+    .delete_property = js_java_view_delete_property,
+    .define_own_property = js_java_view_define_own_property,
+    .set_property = js_java_view_set_property,
+};
+
+static JSClassDef js_java_map_class = {
+    "JavaMap",
+    .finalizer = js_java_view_finalizer,
+    .exotic = &js_java_view_exotic,
+};
+
+static JSClassDef js_java_list_class = {
+    "JavaList",
+    .finalizer = js_java_view_finalizer,
+    .exotic = &js_java_view_exotic,
+};
+
+static void register_java_view_classes(JSRuntime *rt) {
+  if (js_java_map_class_id == 0) {
+    JS_NewClassID(rt, &js_java_map_class_id);
+    JS_NewClassID(rt, &js_java_list_class_id);
+  }
+  JS_NewClass(rt, js_java_map_class_id, &js_java_map_class);
+  JS_NewClass(rt, js_java_list_class_id, &js_java_list_class);
+}
+
+static JSValue new_java_view(JNIEnv *env, JSContext *ctx, jobject target,
+                             int writable) {
+  int is_list = (*env)->IsInstanceOf(env, target, g_ListClass);
+  JSClassID class_id = is_list ? js_java_list_class_id : js_java_map_class_id;
+
+  // List views share Array.prototype so map, filter and iteration work;
+  // map views have a null prototype, like Object.create(null).
+  if (is_list) {
+    JSValue proto = JS_GetClassProto(ctx, class_id);
+    if (JS_IsNull(proto)) {
+      JSValue array = JS_NewArray(ctx);
+      JS_SetClassProto(ctx, class_id, JS_GetPrototype(ctx, array));
+      JS_FreeValue(ctx, array);
+    }
+    JS_FreeValue(ctx, proto);
+  }
+
+  JavaView *view = malloc(sizeof(JavaView));
+  if (!view)
+    return JS_ThrowOutOfMemory(ctx);
+  JSValue obj = JS_NewObjectClass(ctx, class_id);
+  if (JS_IsException(obj)) {
+    free(view);
+    return obj;
+  }
+  view->target = (*env)->NewGlobalRef(env, target);
+  view->writable = writable;
+  JS_SetOpaque(obj, view);
+  return obj;
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_createViewInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jobject collection,
+    jboolean writable) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  CHECK_CONTEXT(ctx);
+  JSValue view = new_java_view(env, ctx, collection, writable);
+  if (JS_IsException(view)) {
+    check_throw_exception(env, ctx, view);
+    return 0;
+  }
+  return boxJSValue(view);
+}
+
+// --- Native console ---
+//
+// console.log and friends format their arguments in C and push the line onto
+// a bounded multi-producer ring (Vyukov's array queue), so logging never
+// calls into Java on the script's thread. A Java thread in JSConsole drains
+// the ring in batches. Rings are shared by every context that installed the
+// same JSConsole, possibly on different runtimes and threads, and are
+// reference counted by those contexts and by the JSConsole itself.
+
+#ifdef _WIN32
+typedef volatile LONG64 ring_pos_t;
+#define RING_LOAD(p) InterlockedCompareExchange64((p), 0, 0)
+#define RING_STORE(p, v) InterlockedExchange64((p), (v))
+#define RING_CAS(p, expected, desired)                                         \
+  (InterlockedCompareExchange64((p), (desired), (expected)) == (expected))
+#define RING_INC(p) InterlockedIncrement64(p)
+#else
+typedef int64_t ring_pos_t;
+#define RING_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RING_CAS(p, expected, desired)                                         \
+  __atomic_compare_exchange_n((p), &(int64_t){(expected)}, (desired), 0,      \
+                              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define RING_INC(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#endif
+
+// Longer lines are truncated
+#define CONSOLE_MAX_MESSAGE 8192
+
+// Levels, matching the order of the Java JSConsole.Level enum
+#define CONSOLE_DEBUG 0
+#define CONSOLE_INFO 1
+#define CONSOLE_WARN 2
+#define CONSOLE_ERROR 3
+
+typedef struct {
+  ring_pos_t seq;
+  int level;
+  int64_t timestamp_ms;
+  // One allocation: the source (if any) is followed by the message
+  char *source;
+  char *message;
+} ConsoleSlot;
+
+typedef struct {
+  sab_ref_t ref_count;
+  volatile int closed;
+  int drop_oldest;
+  int64_t mask;
+  ring_pos_t enqueue_pos;
+  ring_pos_t dequeue_pos;
+  ring_pos_t dropped;
+  ConsoleSlot slots[];
+} ConsoleRing;
+
+// What one context's console functions write to.
+typedef struct {
+  ConsoleRing *ring;
+  char *source;
+} ConsoleBinding;
+
+static JSClassID js_console_class_id;
+
+static int64_t realtime_ms(void) {
+#ifdef _WIN32
+  FILETIME ft;
+  GetSystemTimeAsFileTime(&ft);
+  ULARGE_INTEGER t;
+  t.LowPart = ft.dwLowDateTime;
+  t.HighPart = ft.dwHighDateTime;
+  // 100ns ticks since 1601 to milliseconds since 1970
+  return (int64_t)(t.QuadPart / 10000) - 11644473600000LL;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+static int ring_push(ConsoleRing *ring, ConsoleSlot *record) {
+  int64_t pos = RING_LOAD(&ring->enqueue_pos);
+  ConsoleSlot *slot;
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    int64_t diff = RING_LOAD(&slot->seq) - pos;
+    if (diff == 0) {
+      if (RING_CAS(&ring->enqueue_pos, pos, pos + 1))
+        break;
+      pos = RING_LOAD(&ring->enqueue_pos);
+    } else if (diff < 0) {
+      return 0; // full
+    } else {
+      pos = RING_LOAD(&ring->enqueue_pos);
+    }
+  }
+  slot->level = record->level;
+  slot->timestamp_ms = record->timestamp_ms;
+  slot->source = record->source;
+  slot->message = record->message;
+  RING_STORE(&slot->seq, pos + 1);
+  return 1;
+}
+
+static int ring_pop(ConsoleRing *ring, ConsoleSlot *record) {
+  int64_t pos = RING_LOAD(&ring->dequeue_pos);
+  ConsoleSlot *slot;
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    int64_t diff = RING_LOAD(&slot->seq) - (pos + 1);
+    if (diff == 0) {
+      if (RING_CAS(&ring->dequeue_pos, pos, pos + 1))
+        break;
+      pos = RING_LOAD(&ring->dequeue_pos);
+    } else if (diff < 0) {
+      return 0; // empty
+    } else {
+      pos = RING_LOAD(&ring->dequeue_pos);
+    }
+  }
+  *record = *slot;
+  RING_STORE(&slot->seq, pos + ring->mask + 1);
+  return 1;
+}
+
+static void free_console_record(ConsoleSlot *record) {
+  // source, when set, is the start of the allocation
+  free(record->source ? record->source : record->message);
+}
+
+static void console_ring_release(ConsoleRing *ring) {
+  if (SAB_REF_DEC(&ring->ref_count) != 0)
+    return;
+  ConsoleSlot record;
+  while (ring_pop(ring, &record))
+    free_console_record(&record);
+  free(ring);
+}
+
+// Hand a formatted record to the ring, applying its overflow policy. The ring
+// takes ownership of the record's memory only on success.
+static void console_enqueue(ConsoleRing *ring, ConsoleSlot *record) {
+  if (ring_push(ring, record))
+    return;
+  // Make room by dropping the oldest line, unless a consumer or other
+  // producers win the race for the slot
+  ConsoleSlot oldest;
+  if (ring->drop_oldest && ring_pop(ring, &oldest)) {
+    free_console_record(&oldest);
+    RING_INC(&ring->dropped);
+    if (ring_push(ring, record))
+      return;
+  }
+  free_console_record(record);
+  RING_INC(&ring->dropped);
+}
+
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t cap;
+  int full;
+} ConsoleBuffer;
+
+static void console_append(ConsoleBuffer *b, const char *s, size_t len) {
+  if (b->full)
+    return;
+  if (b->len + len > CONSOLE_MAX_MESSAGE) {
+    len = CONSOLE_MAX_MESSAGE - b->len;
+    // Cut before the character that does not fit, not inside it: back up
+    // while the first dropped byte is a UTF-8 continuation (10xxxxxx).
+    while (len > 0 && ((unsigned char)s[len] & 0xC0) == 0x80)
+      len--;
+    b->full = 1;
+  }
+  if (len == 0)
+    return;
+  if (b->len + len + 1 > b->cap) {
+    size_t cap = b->cap ? b->cap * 2 : 128;
+    while (cap < b->len + len + 1)
+      cap *= 2;
+    char *buf = realloc(b->buf, cap);
+    if (!buf)
+      return;
+    b->buf = buf;
+    b->cap = cap;
+  }
+  memcpy(b->buf + b->len, s, len);
+  b->len += len;
+  b->buf[b->len] = '\0';
+}
+
+// Strings are written as is, plain objects and arrays as JSON, everything
+// else (including errors and functions) through String().
+static void console_append_value(JSContext *ctx, ConsoleBuffer *b,
+                                 JSValueConst val) {
+  JSValue json = JS_UNDEFINED;
+  if (JS_IsObject(val) && !JS_IsFunction(ctx, val) && !JS_IsError(val)) {
+    json = JS_JSONStringify(ctx, val, JS_UNDEFINED, JS_UNDEFINED);
+    if (JS_IsException(json)) {
+      // e.g. cycles; fall back to String()
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      json = JS_UNDEFINED;
+    }
+  }
+  size_t len;
+  const char *str =
+      JS_ToCStringLen(ctx, &len, JS_IsString(json) ? json : val);
+  if (str) {
+    console_append(b, str, len);
+    JS_FreeCString(ctx, str);
+  } else {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    console_append(b, "[unprintable]", 13);
+  }
+  JS_FreeValue(ctx, json);
+}
+
+static JSValue js_console_write(JSContext *ctx, JSValueConst this_val,
+                                int argc, JSValueConst *argv, int magic,
+                                JSValue *func_data) {
+  ConsoleBinding *binding = JS_GetOpaque(func_data[0], js_console_class_id);
+  if (!binding || binding->ring->closed)
+    return JS_UNDEFINED;
+
+  ConsoleBuffer b = {0};
+  size_t source_len = binding->source ? strlen(binding->source) + 1 : 0;
+  if (source_len)
+    console_append(&b, binding->source, source_len);
+  // The message starts after the source and its terminator
+  size_t message_start = b.len;
+  for (int i = 0; i < argc; i++) {
+    if (i > 0)
+      console_append(&b, " ", 1);
+    console_append_value(ctx, &b, argv[i]);
+  }
+  if (!b.buf) {
+    b.buf = malloc(1);
+    if (!b.buf) {
+      RING_INC(&binding->ring->dropped);
+      return JS_UNDEFINED;
+    }
+    b.buf[0] = '\0';
+  }
+
+  ConsoleSlot record;
+  record.level = magic;
+  record.timestamp_ms = realtime_ms();
+  record.source = source_len ? b.buf : NULL;
+  record.message = b.buf + message_start;
+  console_enqueue(binding->ring, &record);
+  return JS_UNDEFINED;
+}
+
+static void js_console_finalizer(JSRuntime *rt, JSValue val) {
+  ConsoleBinding *binding = JS_GetOpaque(val, js_console_class_id);
+  if (binding) {
+    console_ring_release(binding->ring);
+    free(binding->source);
+    free(binding);
+  }
+}
+
+static JSClassDef js_console_class = {
+    .class_name = "ConsoleBinding",
+    .finalizer = js_console_finalizer,
+};
+
+static void register_console_class(JSRuntime *rt) {
+  if (js_console_class_id == 0) {
+    JS_NewClassID(rt, &js_console_class_id);
+  }
+  JS_NewClass(rt, js_console_class_id, &js_console_class);
+}
+
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSConsole_createRingInternal(
+    JNIEnv *env, jclass clazz, jint capacity, jboolean dropOldest) {
+  int64_t size = 2;
+  while (size < capacity)
+    size <<= 1;
+  ConsoleRing *ring =
+      calloc(1, sizeof(ConsoleRing) + size * sizeof(ConsoleSlot));
+  if (!ring) {
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in console ring");
+    return 0;
+  }
+  ring->ref_count = 1;
+  ring->drop_oldest = dropOldest;
+  ring->mask = size - 1;
+  for (int64_t i = 0; i < size; i++)
+    ring->slots[i].seq = i;
+  return (jlong)ring;
+}
+
+// Closes the ring to new lines and drops the JSConsole's reference. Lines
+// still queued are freed with the ring once no context uses it.
+JNIEXPORT void JNICALL Java_com_quickjs_JSConsole_releaseRingInternal(
+    JNIEnv *env, jclass clazz, jlong ringPtr) {
+  ConsoleRing *ring = (ConsoleRing *)ringPtr;
+  ring->closed = 1;
+  console_ring_release(ring);
+}
 
-  ReleaseStringUTFChars(env, json, c_json);
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSConsole_droppedInternal(
+    JNIEnv *env, jclass clazz, jlong ringPtr) {
+  return RING_LOAD(&((ConsoleRing *)ringPtr)->dropped);
+}
 
-  check_throw_exception(env, ctx, val);
-  if (JS_IsException(val)) {
+// Moves up to messages.length queued lines into the arrays and returns how
+// many it moved.
+JNIEXPORT jint JNICALL Java_com_quickjs_JSConsole_drainInternal(
+    JNIEnv *env, jclass clazz, jlong ringPtr, jintArray levels,
+    jlongArray timestamps, jobjectArray sources, jobjectArray messages) {
+  ConsoleRing *ring = (ConsoleRing *)ringPtr;
+  jsize max = (*env)->GetArrayLength(env, messages);
+  jint *c_levels = (*env)->GetIntArrayElements(env, levels, NULL);
+  jlong *c_timestamps = (*env)->GetLongArrayElements(env, timestamps, NULL);
+  if (!c_levels || !c_timestamps) {
+    if (c_levels)
+      (*env)->ReleaseIntArrayElements(env, levels, c_levels, JNI_ABORT);
     return 0;
   }
-
-  return boxJSValue(val);
+  jsize count = 0;
+  ConsoleSlot record;
+  while (count < max && ring_pop(ring, &record)) {
+    c_levels[count] = record.level;
+    c_timestamps[count] = record.timestamp_ms;
+    jstring source =
+        record.source ? (*env)->NewStringUTF(env, record.source) : NULL;
+    jstring message = (*env)->NewStringUTF(env, record.message);
+    free_console_record(&record);
+    (*env)->SetObjectArrayElement(env, sources, count, source);
+    (*env)->SetObjectArrayElement(env, messages, count, message);
+    (*env)->DeleteLocalRef(env, source);
+    (*env)->DeleteLocalRef(env, message);
+    count++;
+  }
+  (*env)->ReleaseIntArrayElements(env, levels, c_levels, 0);
+  (*env)->ReleaseLongArrayElements(env, timestamps, c_timestamps, 0);
+  return count;
 }
 
-JNIEXPORT jstring JNICALL Java_com_quickjs_JSValue_toJSONInternal(
-    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+JNIEXPORT void JNICALL Java_com_quickjs_JSContext_installConsoleInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong ringPtr,
+    jstring source) {
   JSContext *ctx = (JSContext *)contextPtr;
-  JSValue *v = (JSValue *)valPtr;
-
-  JSValue jsonStrVal = JS_JSONStringify(ctx, *v, JS_UNDEFINED, JS_UNDEFINED);
+  CHECK_PTR(ctx, );
+  ConsoleRing *ring = (ConsoleRing *)ringPtr;
 
-  check_throw_exception(env, ctx, jsonStrVal);
-  if (JS_IsException(jsonStrVal)) {
-    return NULL;
+  ConsoleBinding *binding = calloc(1, sizeof(ConsoleBinding));
+  if (!binding) {
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in console binding");
+    return;
+  }
+  if (source) {
+    const char *c_source = GetStringUTFChars(env, source);
+    binding->source = c_source ? strdup(c_source) : NULL;
+    ReleaseStringUTFChars(env, source, c_source);
+  }
+  binding->ring = ring;
+  SAB_REF_INC(&ring->ref_count);
+
+  JSValue holder = JS_NewObjectClass(ctx, js_console_class_id);
+  if (JS_IsException(holder)) {
+    console_ring_release(ring);
+    free(binding->source);
+    free(binding);
+    check_throw_exception(env, ctx, holder);
+    return;
   }
+  JS_SetOpaque(holder, binding);
+
+  static const struct {
+    const char *name;
+    int level;
+  } methods[] = {
+      {"log", CONSOLE_INFO},   {"info", CONSOLE_INFO},
+      {"debug", CONSOLE_DEBUG}, {"trace", CONSOLE_DEBUG},
+      {"warn", CONSOLE_WARN},   {"error", CONSOLE_ERROR},
+  };
+  JSValue console = JS_NewObject(ctx);
+  for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+    JS_SetPropertyStr(ctx, console, methods[i].name,
+                      JS_NewCFunctionData(ctx, js_console_write, 0,
+                                          methods[i].level, 1, &holder));
+  }
+  JS_FreeValue(ctx, holder);
 
-  const char *str = JS_ToCString(ctx, jsonStrVal);
-  jstring res = (*env)->NewStringUTF(env, str);
+  JSValue global = JS_GetGlobalObject(ctx);
+  JS_SetPropertyStr(ctx, global, "console", console);
+  JS_FreeValue(ctx, global);
+}
 
-  JS_FreeCString(ctx, str);
-  JS_FreeValue(ctx, jsonStrVal);
+// --- @JSExport classes ---
+//
+// A binding generated by the annotation processor describes each exported
+// member by name and JNI descriptor. Members are resolved to jmethodIDs once
+// per runtime, and calls convert JS arguments straight into jvalues, so a
+// call from JS costs one JNI upcall with no JSValue boxing.
 
-  return res;
+#define EXPORT_MAX_ARGS 16
+
+typedef struct {
+  char *name;
+  jmethodID method;
+  int is_getter;
+  int argc;
+  char args[EXPORT_MAX_ARGS]; // Z I J F D, or L for java.lang.String
+  char ret;                   // as args, plus V
+} ExportMember;
+
+typedef struct ExportClass {
+  JSClassID class_id;
+  char *class_name;
+  jclass type;
+  int member_count;
+  ExportMember *members;
+} ExportClass;
+
+static void js_export_finalizer(JSRuntime *rt, JSValue val) {
+  jobject target = JS_GetOpaque(val, JS_GetClassID(val));
+  if (target) {
+    JNIEnv *env;
+    if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) == JNI_OK) {
+      (*env)->DeleteGlobalRef(env, target);
+    }
+  }
 }
 
-JNIEXPORT void JNICALL Java_com_quickjs_JSValue_closeInternal(JNIEnv *env,
-                                                              jobject thiz,
-                                                              jlong contextPtr,
-                                                              jlong valPtr) {
-  JSContext *ctx = (JSContext *)contextPtr;
-  JSValue *v = (JSValue *)valPtr;
-  JS_FreeValue(ctx, *v);
-  free(v);
+static void free_export_class(JNIEnv *env, ExportClass *cls) {
+  if (!cls)
+    return;
+  for (int i = 0; i < cls->member_count; i++) {
+    free(cls->members[i].name);
+  }
+  free(cls->members);
+  free(cls->class_name);
+  if (cls->type)
+    (*env)->DeleteGlobalRef(env, cls->type);
+  free(cls);
 }
 
-static JSValue callback_trampoline(JSContext *ctx, JSValueConst this_val,
-                                   int argc, JSValueConst *argv, int magic,
-                                   JSValue *func_data) {
-  JSValue proxy = func_data[0];
-  jobject javaCallback = (jobject)JS_GetOpaque(proxy, js_java_proxy_class_id);
-  if (!javaCallback)
-    return JS_UNDEFINED;
+static void free_export_classes(JNIEnv *env, NativeRuntimeData *data) {
+  for (int i = 0; i < data->export_class_count; i++) {
+    free_export_class(env, data->export_classes[i]);
+  }
+  free(data->export_classes);
+  data->export_classes = NULL;
+  data->export_class_count = 0;
+}
 
-  jweak javaContextWeak = (jweak)JS_GetContextOpaque(ctx);
-  if (!javaContextWeak)
-    return JS_UNDEFINED;
+static char export_type_code(const char **sig) {
+  const char *p = *sig;
+  if (strchr("ZIJFDV", *p)) {
+    *sig = p + 1;
+    return *p;
+  }
+  if (strncmp(p, "Ljava/lang/String;", 18) == 0) {
+    *sig = p + 18;
+    return 'L';
+  }
+  return 0;
+}
 
-  JNIEnv *env;
-  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
-    return JS_ThrowInternalError(ctx, "JNI Env unavailable");
+// Parse "(DLjava/lang/String;)V" into member->args/argc/ret.
+static int parse_export_signature(ExportMember *member, const char *sig) {
+  if (*sig++ != '(')
+    return -1;
+  member->argc = 0;
+  while (*sig && *sig != ')') {
+    char code = export_type_code(&sig);
+    if (!code || code == 'V' || member->argc >= EXPORT_MAX_ARGS)
+      return -1;
+    member->args[member->argc++] = code;
   }
+  if (*sig++ != ')')
+    return -1;
+  member->ret = export_type_code(&sig);
+  return member->ret ? 0 : -1;
+}
 
-  jobject javaContext = (*env)->NewLocalRef(env, javaContextWeak);
-  if (!javaContext) {
-    return JS_ThrowInternalError(ctx, "Java JSContext is dead");
+static ExportClass *find_export_class(NativeRuntimeData *data,
+                                      JSClassID class_id) {
+  for (int i = 0; i < data->export_class_count; i++) {
+    if (data->export_classes[i]->class_id == class_id)
+      return data->export_classes[i];
   }
+  return NULL;
+}
 
-  // Use cached classes and methods
-  jlong thisPtr = boxJSValue(JS_DupValue(ctx, this_val));
-  if (thisPtr == 0)
-    return JS_ThrowInternalError(ctx, "Native Error: OOM in boxJSValue");
+// magic is the member index within the class whose id is func_data[0], so
+// the receiver must be an instance of that class, not just any export.
+static JSValue js_export_invoke(JSContext *ctx, JSValueConst this_val, int argc,
+                                JSValueConst *argv, int magic,
+                                JSValue *func_data) {
+  JSClassID class_id = (JSClassID)JS_VALUE_GET_INT(func_data[0]);
+  ExportClass *cls = JS_GetClassID(this_val) == class_id
+                         ? find_export_class(get_runtime_data(ctx), class_id)
+                         : NULL;
+  jobject target = cls ? JS_GetOpaque(this_val, class_id) : NULL;
+  if (!target)
+    return JS_ThrowTypeError(ctx, "not an exported Java object of this class");
+  ExportMember *m = &cls->members[magic];
 
-  jobject jThis = (*env)->NewObject(env, g_JSValueClass, g_JSValue_ctor,
-                                    thisPtr, javaContext);
-  if (!jThis) {
-    free((void *)thisPtr);
-    return JS_ThrowInternalError(ctx,
-                                 "JNI Error: Failed to create 'this' JSValue");
+  JNIEnv *env;
+  if ((*g_vm)->GetEnv(g_vm, (void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+    return JS_ThrowInternalError(ctx, "JNI Env unavailable");
   }
 
-  jobjectArray jArgs = (*env)->NewObjectArray(env, argc, g_JSValueClass, NULL);
-  if (!jArgs) {
-    (*env)->DeleteLocalRef(env, jThis);
-    return JS_ThrowInternalError(ctx,
-                                 "JNI Error: Failed to create argument array");
+  jvalue jargs[EXPORT_MAX_ARGS];
+  int converted = 0;
+  JSValue result = JS_UNDEFINED;
+  for (; converted < m->argc; converted++) {
+    JSValueConst arg = converted < argc ? argv[converted] : JS_UNDEFINED;
+    jvalue *out = &jargs[converted];
+    int ok = 0;
+    switch (m->args[converted]) {
+    case 'Z': {
+      int b = JS_ToBool(ctx, arg);
+      out->z = b > 0;
+      ok = b >= 0 ? 0 : -1;
+      break;
+    }
+    case 'I': {
+      // jint is long on Windows, so convert through int32_t
+      int32_t v;
+      ok = JS_ToInt32(ctx, &v, arg);
+      out->i = v;
+      break;
+    }
+    case 'J': {
+      int64_t v;
+      ok = JS_ToInt64(ctx, &v, arg);
+      out->j = v;
+      break;
+    }
+    case 'F': {
+      double d;
+      ok = JS_ToFloat64(ctx, &d, arg);
+      out->f = (jfloat)d;
+      break;
+    }
+    case 'D':
+      ok = JS_ToFloat64(ctx, &out->d, arg);
+      break;
+    case 'L': {
+      out->l = NULL;
+      if (JS_IsNull(arg) || JS_IsUndefined(arg))
+        break;
+      const char *str = JS_ToCString(ctx, arg);
+      if (!str) {
+        ok = -1;
+        break;
+      }
+      out->l = (*env)->NewStringUTF(env, str);
+      JS_FreeCString(ctx, str);
+      ok = out->l ? 0 : -1;
+      break;
+    }
+    }
+    if (ok < 0) {
+      result = JS_EXCEPTION;
+      break;
+    }
   }
 
-  for (int i = 0; i < argc; i++) {
-    jlong argPtr = boxJSValue(JS_DupValue(ctx, argv[i]));
-    if (argPtr == 0) {
-      (*env)->DeleteLocalRef(env, jThis);
-      (*env)->DeleteLocalRef(env, jArgs);
-      return JS_ThrowInternalError(ctx, "Native Error: OOM in argument boxing");
+  if (!JS_IsException(result)) {
+    switch (m->ret) {
+    case 'V':
+      (*env)->CallVoidMethodA(env, target, m->method, jargs);
+      break;
+    case 'Z':
+      result = JS_NewBool(
+          ctx, (*env)->CallBooleanMethodA(env, target, m->method, jargs));
+      break;
+    case 'I':
+      result = JS_NewInt32(
+          ctx, (*env)->CallIntMethodA(env, target, m->method, jargs));
+      break;
+    case 'J':
+      result = JS_NewInt64(
+          ctx, (*env)->CallLongMethodA(env, target, m->method, jargs));
+      break;
+    case 'F':
+      result = JS_NewFloat64(
+          ctx, (*env)->CallFloatMethodA(env, target, m->method, jargs));
+      break;
+    case 'D':
+      result = JS_NewFloat64(
+          ctx, (*env)->CallDoubleMethodA(env, target, m->method, jargs));
+      break;
+    case 'L': {
+      jstring str = (jstring)(*env)->CallObjectMethodA(env, target, m->method,
+                                                       jargs);
+      if (str) {
+        const char *c_str = GetStringUTFChars(env, str);
+        result = c_str ? JS_NewString(ctx, c_str) : JS_ThrowOutOfMemory(ctx);
+        ReleaseStringUTFChars(env, str, c_str);
+        (*env)->DeleteLocalRef(env, str);
+      } else {
+        result = JS_NULL;
+      }
+      break;
     }
-    jobject jArg = (*env)->NewObject(env, g_JSValueClass, g_JSValue_ctor,
-                                     argPtr, javaContext);
-    if (!jArg) {
-      free((void *)argPtr);
-      (*env)->DeleteLocalRef(env, jThis);
-      (*env)->DeleteLocalRef(env, jArgs);
-      return JS_ThrowInternalError(
-          ctx, "JNI Error: Failed to create argument JSValue");
     }
-    (*env)->SetObjectArrayElement(env, jArgs, i, jArg);
-    (*env)->DeleteLocalRef(env, jArg);
   }
 
-  jobject jResult = (*env)->CallObjectMethod(
-      env, javaCallback, g_JSFunction_apply, javaContext, jThis, jArgs);
-
-  (*env)->DeleteLocalRef(env, javaContext);
-  (*env)->DeleteLocalRef(env, jThis);
-  (*env)->DeleteLocalRef(env, jArgs);
+  for (int i = 0; i < converted; i++) {
+    if (m->args[i] == 'L' && jargs[i].l)
+      (*env)->DeleteLocalRef(env, jargs[i].l);
+  }
 
   if ((*env)->ExceptionCheck(env)) {
-    jthrowable ex = (*env)->ExceptionOccurred(env);
-    (*env)->ExceptionClear(env);
-
-    jclass exCls = (*env)->GetObjectClass(env, ex);
-    jstring msg = NULL;
+    JS_FreeValue(ctx, result);
+    return throw_js_from_java_exception(env, ctx);
+  }
+  return result;
+}
 
-    jmethodID toString =
-        (*env)->GetMethodID(env, exCls, "toString", "()Ljava/lang/String;");
-    if (toString) {
-      msg = (jstring)(*env)->CallObjectMethod(env, ex, toString);
-    }
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSRuntime_registerExportClassInternal(
+    JNIEnv *env, jobject thiz, jlong runtimePtr, jclass type, jstring className,
+    jobjectArray jsNames, jobjectArray javaNames, jobjectArray signatures,
+    jbooleanArray getters) {
+  JSRuntime *rt = (JSRuntime *)runtimePtr;
+  CHECK_RUNTIME(rt);
+  NativeRuntimeData *data = (NativeRuntimeData *)JS_GetRuntimeOpaque(rt);
 
-    // Fallback if toString fails
-    const char *c_msg = "Unknown Java Exception";
-    if (msg) {
-      const char *temp_msg = GetStringUTFChars(env, msg);
-      if (temp_msg)
-        c_msg = temp_msg;
-    }
+  int count = (*env)->GetArrayLength(env, jsNames);
+  if (count > INT16_MAX) {
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Too many exported members in one class");
+    return 0;
+  }
+  ExportClass **classes =
+      realloc(data->export_classes,
+              sizeof(ExportClass *) * (data->export_class_count + 1));
+  if (!classes)
+    return 0;
+  data->export_classes = classes;
 
-    JSValue err = JS_NewError(ctx);
-    JS_DefinePropertyValueStr(ctx, err, "message", JS_NewString(ctx, c_msg),
-                              JS_PROP_C_W_E);
+  ExportClass *cls = calloc(1, sizeof(ExportClass));
+  if (!cls)
+    return 0;
+  cls->members = calloc(count > 0 ? count : 1, sizeof(ExportMember));
+  const char *c_class_name = GetStringUTFChars(env, className);
+  cls->class_name = c_class_name ? strdup(c_class_name) : NULL;
+  ReleaseStringUTFChars(env, className, c_class_name);
+  cls->type = (*env)->NewGlobalRef(env, type);
+  if (!cls->members || !cls->class_name || !cls->type) {
+    free_export_class(env, cls);
+    return 0;
+  }
 
-    if (msg) {
-      const char *temp_msg =
-          GetStringUTFChars(env, msg); // Re-get to release properly
-      if (temp_msg)
-        ReleaseStringUTFChars(env, msg, temp_msg);
-      (*env)->DeleteLocalRef(env, msg);
+  jboolean *isGetter = (*env)->GetBooleanArrayElements(env, getters, NULL);
+  for (int i = 0; i < count; i++) {
+    ExportMember *m = &cls->members[i];
+    cls->member_count = i + 1;
+    jstring jsName = (*env)->GetObjectArrayElement(env, jsNames, i);
+    jstring javaName = (*env)->GetObjectArrayElement(env, javaNames, i);
+    jstring sig = (*env)->GetObjectArrayElement(env, signatures, i);
+    const char *c_js = GetStringUTFChars(env, jsName);
+    const char *c_java = GetStringUTFChars(env, javaName);
+    const char *c_sig = GetStringUTFChars(env, sig);
+
+    m->name = c_js ? strdup(c_js) : NULL;
+    m->is_getter = isGetter[i];
+    int valid = m->name && c_java && c_sig &&
+                parse_export_signature(m, c_sig) == 0;
+    if (valid) {
+      // Throws NoSuchMethodError if the binding is stale
+      m->method = (*env)->GetMethodID(env, type, c_java, c_sig);
+    } else if (!(*env)->ExceptionCheck(env)) {
+      (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                       "Unsupported @JSExport member signature");
     }
-    (*env)->DeleteLocalRef(env, ex);
-    (*env)->DeleteLocalRef(env, exCls);
 
-    return JS_Throw(ctx, err);
+    ReleaseStringUTFChars(env, jsName, c_js);
+    ReleaseStringUTFChars(env, javaName, c_java);
+    ReleaseStringUTFChars(env, sig, c_sig);
+    (*env)->DeleteLocalRef(env, jsName);
+    (*env)->DeleteLocalRef(env, javaName);
+    (*env)->DeleteLocalRef(env, sig);
+    if (!m->method)
+      break;
   }
-
-  if (jResult == NULL) {
-    return JS_UNDEFINED;
+  (*env)->ReleaseBooleanArrayElements(env, getters, isGetter, JNI_ABORT);
+  if ((*env)->ExceptionCheck(env)) {
+    free_export_class(env, cls);
+    return 0;
   }
 
-  jlong resPtr = (*env)->GetLongField(env, jResult, g_JSValue_ptr);
+  JSClassDef def = {
+      .class_name = cls->class_name,
+      .finalizer = js_export_finalizer,
+  };
+  JS_NewClassID(rt, &cls->class_id);
+  if (JS_NewClass(rt, cls->class_id, &def) < 0) {
+    free_export_class(env, cls);
+    return 0;
+  }
 
-  JSValue *resValPtr = (JSValue *)resPtr;
-  JSValue resVal = JS_DupValue(ctx, *resValPtr);
+  data->export_classes[data->export_class_count++] = cls;
+  return (jlong)cls;
+}
 
-  (*env)->DeleteLocalRef(env, jResult);
+JNIEXPORT void JNICALL Java_com_quickjs_JSContext_installExportClassInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong classPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  ExportClass *cls = (ExportClass *)classPtr;
+  if (!ctx || !cls)
+    return;
 
-  return resVal;
+  JSValue proto = JS_NewObject(ctx);
+  for (int i = 0; i < cls->member_count; i++) {
+    ExportMember *m = &cls->members[i];
+    JSValue class_id = JS_NewInt32(ctx, (int32_t)cls->class_id);
+    JSValue func = JS_NewCFunctionData(ctx, js_export_invoke, m->argc, i, 1,
+                                       &class_id);
+    JS_DefinePropertyValueStr(ctx, func, "name", JS_NewString(ctx, m->name),
+                              JS_PROP_CONFIGURABLE);
+    if (m->is_getter) {
+      JSAtom atom = JS_NewAtom(ctx, m->name);
+      JS_DefinePropertyGetSet(ctx, proto, atom, func, JS_UNDEFINED,
+                              JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE);
+      JS_FreeAtom(ctx, atom);
+    } else {
+      JS_DefinePropertyValueStr(ctx, proto, m->name, func,
+                                JS_PROP_CONFIGURABLE | JS_PROP_WRITABLE);
+    }
+  }
+  JS_SetClassProto(ctx, cls->class_id, proto);
 }
 
-JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_createFunctionInternal(
-    JNIEnv *env, jobject thiz, jlong contextPtr, jobject callback, jstring name,
-    jint argCount) {
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_newExportObjectInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong classPtr,
+    jobject target) {
   JSContext *ctx = (JSContext *)contextPtr;
-  if (!ctx)
+  ExportClass *cls = (ExportClass *)classPtr;
+  if (!ctx || !cls)
     return 0;
 
-  jobject cbGlobal = (*env)->NewGlobalRef(env, callback);
-
-  JSValue proxy = JS_NewObjectClass(ctx, js_java_proxy_class_id);
-  JS_SetOpaque(proxy, cbGlobal);
-
-  const char *c_name = GetStringUTFChars(env, name);
-
-  JSValue func_data[1];
-  func_data[0] = proxy;
-
-  JSValue func =
-      JS_NewCFunctionData(ctx, callback_trampoline, argCount, 0, 1, func_data);
-  JS_DefinePropertyValueStr(ctx, func, "name", JS_NewString(ctx, c_name),
-                            JS_PROP_CONFIGURABLE);
-
-  ReleaseStringUTFChars(env, name, c_name);
-
-  JS_FreeValue(ctx, proxy);
-
-  return boxJSValue(func);
+  JSValue obj = JS_NewObjectClass(ctx, cls->class_id);
+  if (JS_IsException(obj)) {
+    check_throw_exception(env, ctx, obj);
+    return 0;
+  }
+  JS_SetOpaque(obj, (*env)->NewGlobalRef(env, target));
+  return boxJSValue(obj);
 }
 
 JNIEXPORT jlong JNICALL Java_com_quickjs_JSContext_createIntegerInternal(
@@ -1011,13 +4357,13 @@ JNIEXPORT jobjectArray JNICALL Java_com_quickjs_JSValue_getKeysInternal(
   if (JS_GetOwnPropertyNames(ctx, &tab, &len, *obj,
                              JS_GPN_STRING_MASK | JS_GPN_SYMBOL_MASK |
                                  JS_GPN_ENUM_ONLY) == -1) {
+    check_throw_exception(env, ctx, JS_EXCEPTION);
     return NULL;
   }
 
-  jclass stringCls = (*env)->FindClass(env, "java/lang/String");
-  jobjectArray keys = (*env)->NewObjectArray(env, len, stringCls, NULL);
+  jobjectArray keys = (*env)->NewObjectArray(env, len, g_StringClass, NULL);
 
-  for (uint32_t i = 0; i < len; i++) {
+  for (uint32_t i = 0; keys && i < len; i++) {
     JSValue val = JS_AtomToValue(ctx, tab[i].atom);
     const char *str = JS_ToCString(ctx, val);
     jstring jstr = (*env)->NewStringUTF(env, str);
@@ -1029,11 +4375,248 @@ JNIEXPORT jobjectArray JNICALL Java_com_quickjs_JSValue_getKeysInternal(
     JS_FreeValue(ctx, val);
   }
 
-  js_free(ctx, tab);
+  JS_FreePropertyEnum(ctx, tab, len);
 
   return keys;
 }
 
+// Own enumerable string-keyed properties as {String[] keys, long[] values},
+// read in one pass
+JNIEXPORT jobjectArray JNICALL Java_com_quickjs_JSValue_entriesInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *obj = (JSValue *)valPtr;
+
+  if (!ctx || !obj)
+    return NULL;
+
+  JSPropertyEnum *tab;
+  uint32_t len;
+  if (JS_GetOwnPropertyNames(ctx, &tab, &len, *obj,
+                             JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) == -1) {
+    check_throw_exception(env, ctx, JS_EXCEPTION);
+    return NULL;
+  }
+
+  jobjectArray result = (*env)->NewObjectArray(env, 2, g_ObjectClass, NULL);
+  jobjectArray keys =
+      result ? (*env)->NewObjectArray(env, len, g_StringClass, NULL) : NULL;
+  jlongArray values = keys ? (*env)->NewLongArray(env, len) : NULL;
+  jlong *ptrs = values ? (*env)->GetLongArrayElements(env, values, NULL) : NULL;
+  if (!ptrs) {
+    // A Java OutOfMemoryError is pending
+    JS_FreePropertyEnum(ctx, tab, len);
+    return NULL;
+  }
+
+  // From here on, every failure frees the values read so far, the pinned
+  // array and the property enum
+  uint32_t i = 0;
+  JSValue error = JS_UNDEFINED;
+  for (; i < len; i++) {
+    JSValue val = JS_GetProperty(ctx, *obj, tab[i].atom);
+    if (JS_IsException(val)) {
+      error = val;
+      break;
+    }
+    ptrs[i] = boxJSValue(val);
+    if (!ptrs[i]) {
+      JS_FreeValue(ctx, val);
+      error = JS_ThrowOutOfMemory(ctx);
+      break;
+    }
+
+    const char *str = JS_AtomToCString(ctx, tab[i].atom);
+    if (!str) {
+      i++;
+      error = JS_EXCEPTION;
+      break;
+    }
+    jstring jstr = (*env)->NewStringUTF(env, str);
+    JS_FreeCString(ctx, str);
+    if (!jstr) {
+      i++;
+      break;
+    }
+    (*env)->SetObjectArrayElement(env, keys, i, jstr);
+    (*env)->DeleteLocalRef(env, jstr);
+  }
+  JS_FreePropertyEnum(ctx, tab, len);
+
+  if (i < len) {
+    for (uint32_t j = 0; j < i; j++) {
+      JS_FreeValue(ctx, *(JSValue *)ptrs[j]);
+      free((void *)ptrs[j]);
+    }
+    (*env)->ReleaseLongArrayElements(env, values, ptrs, JNI_ABORT);
+    // Either a JS exception, or a Java one already pending
+    if (JS_IsException(error))
+      check_throw_exception(env, ctx, error);
+    return NULL;
+  }
+  (*env)->ReleaseLongArrayElements(env, values, ptrs, 0);
+
+  (*env)->SetObjectArrayElement(env, result, 0, keys);
+  (*env)->SetObjectArrayElement(env, result, 1, values);
+  return result;
+}
+
+// Start the iteration protocol on an iterable, returning the iterator and
+// storing its next method in nextOut[0], read once as the protocol requires.
+// Returns 0 without an exception if the value has no Symbol.iterator method.
+JNIEXPORT jlong JNICALL Java_com_quickjs_JSValue_iteratorInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong valPtr,
+    jlongArray nextOut) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue *obj = (JSValue *)valPtr;
+  CHECK_CONTEXT(ctx);
+
+  // The well-known symbol, not whatever globalThis.Symbol.iterator is now
+  NativeContextData *cd = get_context_data(ctx);
+  if (!cd || cd->iterator_atom == JS_ATOM_NULL)
+    return 0;
+  JSValue method = JS_GetProperty(ctx, *obj, cd->iterator_atom);
+  if (JS_IsException(method)) {
+    check_throw_exception(env, ctx, method);
+    return 0;
+  }
+  if (!JS_IsFunction(ctx, method)) {
+    JS_FreeValue(ctx, method);
+    return 0;
+  }
+
+  InvocationScope scope;
+  enter_invocation(ctx, &scope, NO_LIMIT, NO_LIMIT);
+  JSValue iter = JS_Call(ctx, method, *obj, 0, NULL);
+  int timed_out = leave_invocation(ctx, &scope);
+  JS_FreeValue(ctx, method);
+
+  if (!JS_IsException(iter) && !JS_IsObject(iter)) {
+    JS_FreeValue(ctx, iter);
+    iter = JS_ThrowTypeError(ctx, "iterator is not an object");
+  }
+  check_throw_invocation(env, ctx, iter, timed_out);
+  if (JS_IsException(iter)) {
+    return 0;
+  }
+
+  JSValue next = JS_GetPropertyStr(ctx, iter, "next");
+  if (JS_IsException(next)) {
+    JS_FreeValue(ctx, iter);
+    check_throw_exception(env, ctx, next);
+    return 0;
+  }
+  jlong nextPtr = boxJSValue(next);
+  jlong iterPtr = nextPtr ? boxJSValue(iter) : 0;
+  if (!iterPtr) {
+    if (nextPtr)
+      free((void *)nextPtr);
+    JS_FreeValue(ctx, next);
+    JS_FreeValue(ctx, iter);
+    (*env)->ThrowNew(env, g_QuickJSExceptionClass,
+                     "Native Error: OOM in iterator");
+    return 0;
+  }
+  (*env)->SetLongArrayRegion(env, nextOut, 0, 1, &nextPtr);
+  return iterPtr;
+}
+
+// Pull up to out.length values from an iterator, boxing them into out.
+// Returns the number read; fewer than requested means the iterator is done.
+JNIEXPORT jint JNICALL Java_com_quickjs_JSValue_nextChunkInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong iterPtr, jlong nextPtr,
+    jlongArray out) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue iter = *(JSValue *)iterPtr;
+  JSValue next = *(JSValue *)nextPtr;
+
+  jint cap = (*env)->GetArrayLength(env, out);
+  jlong *ptrs = (*env)->GetLongArrayElements(env, out, NULL);
+  if (!ptrs)
+    return 0;
+
+  InvocationScope scope;
+  enter_invocation(ctx, &scope, NO_LIMIT, NO_LIMIT);
+  jint count = 0;
+  JSValue error = JS_UNDEFINED;
+  while (count < cap) {
+    JSValue res = JS_Call(ctx, next, iter, 0, NULL);
+    if (JS_IsException(res)) {
+      error = res;
+      break;
+    }
+    if (!JS_IsObject(res)) {
+      JS_FreeValue(ctx, res);
+      error = JS_ThrowTypeError(ctx, "iterator result is not an object");
+      break;
+    }
+    JSValue done_val = JS_GetPropertyStr(ctx, res, "done");
+    int done = JS_ToBool(ctx, done_val);
+    JS_FreeValue(ctx, done_val);
+    if (done) {
+      JS_FreeValue(ctx, res);
+      if (done < 0)
+        error = JS_EXCEPTION;
+      break;
+    }
+    JSValue value = JS_GetPropertyStr(ctx, res, "value");
+    JS_FreeValue(ctx, res);
+    if (JS_IsException(value)) {
+      error = value;
+      break;
+    }
+    ptrs[count] = boxJSValue(value);
+    if (!ptrs[count]) {
+      JS_FreeValue(ctx, value);
+      error = JS_ThrowOutOfMemory(ctx);
+      break;
+    }
+    count++;
+  }
+  int timed_out = leave_invocation(ctx, &scope);
+
+  if (JS_IsException(error)) {
+    while (count-- > 0) {
+      JS_FreeValue(ctx, *(JSValue *)ptrs[count]);
+      free((void *)ptrs[count]);
+    }
+    (*env)->ReleaseLongArrayElements(env, out, ptrs, JNI_ABORT);
+    check_throw_invocation(env, ctx, error, timed_out);
+    return 0;
+  }
+  (*env)->ReleaseLongArrayElements(env, out, ptrs, 0);
+  return count;
+}
+
+// IteratorClose: let an iterator that was not exhausted clean up through its
+// return method, if it has one, e.g. to run a generator's finally blocks.
+JNIEXPORT void JNICALL Java_com_quickjs_JSValue_returnIteratorInternal(
+    JNIEnv *env, jobject thiz, jlong contextPtr, jlong iterPtr) {
+  JSContext *ctx = (JSContext *)contextPtr;
+  JSValue iter = *(JSValue *)iterPtr;
+
+  JSValue method = JS_GetPropertyStr(ctx, iter, "return");
+  if (JS_IsException(method)) {
+    check_throw_exception(env, ctx, method);
+    return;
+  }
+  if (JS_IsUndefined(method) || JS_IsNull(method))
+    return;
+
+  InvocationScope scope;
+  enter_invocation(ctx, &scope, NO_LIMIT, NO_LIMIT);
+  JSValue res = JS_Call(ctx, method, iter, 0, NULL);
+  int timed_out = leave_invocation(ctx, &scope);
+  JS_FreeValue(ctx, method);
+
+  if (!JS_IsException(res) && !JS_IsObject(res)) {
+    JS_FreeValue(ctx, res);
+    res = JS_ThrowTypeError(ctx, "iterator result is not an object");
+  }
+  check_throw_invocation(env, ctx, res, timed_out);
+  JS_FreeValue(ctx, res);
+}
+
 JNIEXPORT jboolean JNICALL Java_com_quickjs_JSRuntime_executePendingJobInternal(
     JNIEnv *env, jclass clazz, jlong runtimePtr) {
   JSRuntime *rt = (JSRuntime *)runtimePtr;
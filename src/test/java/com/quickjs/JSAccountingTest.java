@@ -0,0 +1,67 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSAccountingTest {
+
+    @Test
+    public void testStatsPerInvocation() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            assertNull(runtime.getLastInvocationStats());
+            runtime.enableAccounting();
+
+            context.eval("var objects = []; for (let i = 0; i < 10000; i++) objects.push({ i });").close();
+            JSInvocationStats heavy = runtime.getLastInvocationStats();
+            assertNotNull(heavy);
+            assertTrue(heavy.getAllocations() > 0);
+            assertTrue(heavy.getAllocatedBytes() >= 10000 * 16);
+            assertTrue(heavy.getInterruptChecks() > 0);
+            assertTrue(heavy.getWallNanos() > 0);
+            assertTrue(heavy.getCpuNanos() >= 0);
+
+            context.eval("1 + 1").close();
+            JSInvocationStats light = runtime.getLastInvocationStats();
+            assertNotSame(heavy, light);
+            assertTrue(light.getAllocatedBytes() < heavy.getAllocatedBytes());
+
+            runtime.disableAccounting();
+            context.eval("2 + 2").close();
+            assertSame(light, runtime.getLastInvocationStats());
+        }
+    }
+
+    @Test
+    public void testNestedInvocationsCountTowardsOuter() {
+        List<JSInvocationStats> stats = new ArrayList<>();
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableAccounting(stats::add);
+            JSFunction nested = (ctx, thisObj, args) -> ctx.eval("[1, 2, 3].map(x => x * 2)");
+            try (JSValue fn = context.createFunction(nested, "nested", 0)) {
+                context.setGlobal("nested", fn);
+            }
+            try (JSValue fn = context.eval("(function() { return nested(); })")) {
+                fn.call(null).close();
+            }
+        }
+        // The eval creating the function, then the call including its nested eval
+        assertEquals(2, stats.size());
+    }
+
+    @Test
+    public void testTimedOutInvocationIsRecorded() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableAccounting();
+            assertThrows(JSTimeoutException.class,
+                    () -> context.eval("for (;;) {}", JSExecutionLimit.interruptChecks(5)));
+            assertEquals(5, runtime.getLastInvocationStats().getInterruptChecks());
+        }
+    }
+}
@@ -0,0 +1,68 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.DoubleBuffer;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSBatchTest {
+
+    @Test
+    public void testPrimitiveAndStringColumns() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue fn = context.eval("(function(name, qty, price, vip) {"
+                        + "  return name + ':' + (vip ? qty * price * 0.5 : qty * price);"
+                        + "})")) {
+            String[] names = { "a", "b", "c" };
+            int[] qty = { 1, 2, 3 };
+            double[] price = { 10, 2.5, 1 };
+            boolean[] vip = { false, true, false };
+
+            String[] out = context.mapBatch(fn, new Object[] { names, qty, price, vip }, 3, new String[3]);
+            assertArrayEquals(new String[] { "a:10", "b:2.5", "c:3" }, out);
+        }
+    }
+
+    @Test
+    public void testDirectBufferColumns() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue fn = context.eval("(x) => x * 2")) {
+            DoubleBuffer in = ByteBuffer.allocateDirect(4 * Double.BYTES).order(ByteOrder.nativeOrder())
+                    .asDoubleBuffer();
+            in.put(new double[] { 99, 1, 2, 3 }).flip().position(1);
+            long[] out = context.mapBatch(fn, new Object[] { in }, 3, new long[3]);
+            assertArrayEquals(new long[] { 2, 4, 6 }, out);
+        }
+    }
+
+    @Test
+    public void testExceptionStopsBatch() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue fn = context.eval("(x) => { if (x === 2) throw new RangeError('bad row'); return x; }")) {
+            int[] out = new int[3];
+            assertThrows(JSRangeError.class,
+                    () -> context.mapBatch(fn, new Object[] { new int[] { 1, 2, 3 } }, 3, out));
+            assertEquals(1, out[0]);
+        }
+    }
+
+    @Test
+    public void testShortColumnIsRejected() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue fn = context.eval("(x) => x")) {
+            assertThrows(IllegalArgumentException.class,
+                    () -> context.mapBatch(fn, new Object[] { new int[2] }, 3, new int[3]));
+            DoubleBuffer readOnly = ByteBuffer.allocateDirect(3 * Double.BYTES).order(ByteOrder.nativeOrder())
+                    .asDoubleBuffer().asReadOnlyBuffer();
+            assertThrows(IllegalArgumentException.class,
+                    () -> context.mapBatch(fn, new Object[] { new int[3] }, 3, readOnly));
+        }
+    }
+}
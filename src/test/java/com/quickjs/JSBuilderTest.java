@@ -48,4 +48,18 @@ public class JSBuilderTest {
             }
         }
     }
+
+    @Test
+    public void testMemoryLimitCoversSharedArrayBuffers() {
+        long limit = 5 * 1024 * 1024;
+        try (JSRuntime runtime = QuickJS.builder().withMemoryLimit(limit).build();
+                JSContext context = runtime.createContext()) {
+            context.eval("var a = new SharedArrayBuffer(1024 * 1024);").close();
+            assertThrows(QuickJSException.class,
+                    () -> context.eval("var b = new SharedArrayBuffer(10 * 1024 * 1024);"));
+            // Shared buffers count towards the limit of ordinary allocations too
+            context.eval("var c = new SharedArrayBuffer(3 * 1024 * 1024);").close();
+            assertThrows(QuickJSException.class, () -> context.eval("var d = new Uint8Array(2 * 1024 * 1024);"));
+        }
+    }
 }
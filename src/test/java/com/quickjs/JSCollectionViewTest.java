@@ -0,0 +1,91 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSCollectionViewTest {
+
+    @Test
+    public void testMapViewReadsThrough() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            Map<String, Object> table = new LinkedHashMap<>();
+            table.put("a", 1);
+            table.put("b", "two");
+            table.put("nested", Arrays.asList(3, 4));
+            try (JSValue view = context.createMapView(table, false)) {
+                context.setGlobal("table", view);
+            }
+
+            assertEquals(1, context.eval("table.a").asInteger());
+            assertEquals("two", context.eval("table.b").asString());
+            assertEquals(4, context.eval("table.nested[1]").asInteger());
+            assertTrue(context.eval("table.missing === undefined && !('missing' in table)").asBoolean());
+            assertEquals("a,b,nested", context.eval("Object.keys(table).join()").asString());
+
+            // Changes on the Java side are visible without re-exposing the map
+            table.put("c", 3.5);
+            assertEquals(3.5, context.eval("table.c").asDouble());
+        }
+    }
+
+    @Test
+    public void testReadOnlyViewRejectsWrites() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            Map<String, Object> table = new HashMap<>();
+            table.put("a", 1);
+            try (JSValue view = context.createMapView(table, false)) {
+                context.setGlobal("table", view);
+            }
+
+            assertThrows(JSTypeError.class, () -> context.eval("table.a = 2"));
+            assertThrows(JSTypeError.class, () -> context.eval("delete table.a"));
+            assertEquals(1, table.get("a"));
+        }
+    }
+
+    @Test
+    public void testWritableMapView() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            Map<String, Object> table = new HashMap<>();
+            table.put("gone", true);
+            try (JSValue view = context.createMapView(table, true)) {
+                context.setGlobal("table", view);
+            }
+
+            context.eval("table.count = 7; table.name = 'x'; delete table.gone");
+            assertEquals(7, table.get("count"));
+            assertEquals("x", table.get("name"));
+            assertFalse(table.containsKey("gone"));
+        }
+    }
+
+    @Test
+    public void testListView() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            List<Object> list = new ArrayList<>(Arrays.asList(1, 2, 3));
+            try (JSValue view = context.createListView(list, true)) {
+                context.setGlobal("list", view);
+            }
+
+            assertEquals(3, context.eval("list.length").asInteger());
+            assertEquals(6, context.eval("let s = 0; for (const x of list) s += x; s").asInteger());
+            assertEquals("2,4,6", context.eval("list.map(x => x * 2).join()").asString());
+
+            context.eval("list[0] = 10; list.push(4)");
+            assertEquals(Arrays.asList(10, 2, 3, 4), list);
+            assertThrows(JSRangeError.class, () -> context.eval("list.length = 0"));
+        }
+    }
+}
@@ -0,0 +1,138 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSConsoleTest {
+
+    @Test
+    public void testFormatsAndDeliversLines() {
+        List<JSConsoleRecord> records = Collections.synchronizedList(new ArrayList<>());
+        try (JSConsole console = JSConsole.create(records::addAll);
+                JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            context.setConsole(console, "tenant-a");
+            context.eval("console.log('hello', 42, { a: [1, 2] }, null);"
+                    + "console.warn(new TypeError('bad'));"
+                    + "console.debug();").close();
+            console.flush();
+
+            assertEquals(3, records.size());
+            assertEquals("hello 42 {\"a\":[1,2]} null", records.get(0).getMessage());
+            assertEquals(JSConsole.Level.INFO, records.get(0).getLevel());
+            assertEquals("tenant-a", records.get(0).getSource());
+            assertEquals("TypeError: bad", records.get(1).getMessage());
+            assertEquals(JSConsole.Level.WARN, records.get(1).getLevel());
+            assertEquals("", records.get(2).getMessage());
+            assertTrue(records.get(0).getTimestampMillis() > 0);
+            assertEquals(3, console.getDeliveredCount());
+        }
+    }
+
+    @Test
+    public void testTruncatesOnCharacterBoundary() {
+        List<JSConsoleRecord> records = Collections.synchronizedList(new ArrayList<>());
+        try (JSConsole console = JSConsole.create(records::addAll);
+                JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            context.setConsole(console);
+            // 1 + 3 * 2730 = 8191 bytes fit; the next three-byte character does not
+            context.eval("console.log('a' + '\u20ac'.repeat(5000), 'tail')").close();
+            console.flush();
+
+            assertEquals(1, records.size());
+            assertEquals("a" + "\u20ac".repeat(2730), records.get(0).getMessage());
+        }
+    }
+
+    @Test
+    public void testOverflowDropsNewest() throws InterruptedException {
+        List<String> messages = Collections.synchronizedList(new ArrayList<>());
+        Object gate = new Object();
+        JSConsoleSink slowSink = batch -> {
+            synchronized (gate) {
+                batch.forEach(r -> messages.add(r.getMessage()));
+            }
+        };
+        try (JSConsole console = JSConsole.create(slowSink, 4, JSConsole.OverflowPolicy.DROP_NEWEST);
+                JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            context.setConsole(console);
+            synchronized (gate) {
+                // At most one batch can be taken by the blocked drain thread
+                context.eval("for (let i = 0; i < 100; i++) console.log(i)").close();
+            }
+            console.flush();
+            assertTrue(console.getDroppedCount() > 0);
+            assertEquals(100, console.getDroppedCount() + console.getDeliveredCount());
+            assertEquals("0", messages.get(0));
+        }
+    }
+
+    @Test
+    public void testLoggingAfterCloseIsDiscarded() {
+        List<JSConsoleRecord> records = Collections.synchronizedList(new ArrayList<>());
+        JSConsole console = JSConsole.create(records::addAll);
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            context.setConsole(console);
+            context.eval("console.log('early')").close();
+            console.close();
+            context.eval("console.log('late')").close();
+            assertEquals(1, records.size());
+            assertThrows(IllegalStateException.class, () -> context.setConsole(console));
+        }
+    }
+
+    @Test
+    public void testBlockedSinkDoesNotBlockConsole() throws InterruptedException {
+        CountDownLatch entered = new CountDownLatch(1);
+        CountDownLatch release = new CountDownLatch(1);
+        JSConsoleSink blockedSink = batch -> {
+            entered.countDown();
+            try {
+                release.await();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            }
+        };
+        try (JSConsole console = JSConsole.create(blockedSink);
+                JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSContext other = runtime.createContext()) {
+            context.setConsole(console);
+            context.eval("console.log('blocks the sink')").close();
+            entered.await();
+            // Would deadlock if the sink ran under the console's lock
+            assertTimeout(java.time.Duration.ofSeconds(5), () -> {
+                assertEquals(0, console.getDroppedCount());
+                other.setConsole(console);
+            });
+            release.countDown();
+        }
+    }
+
+    @Test
+    public void testAbandonedConsoleStopsItsThread() throws InterruptedException {
+        long before = consoleThreads();
+        JSConsole.create(batch -> { });
+        long deadline = System.nanoTime() + 10_000_000_000L;
+        while (consoleThreads() > before && System.nanoTime() < deadline) {
+            System.gc();
+            Thread.sleep(10);
+        }
+        assertEquals(before, consoleThreads());
+    }
+
+    private static long consoleThreads() {
+        return Thread.getAllStackTraces().keySet().stream()
+                .filter(t -> t.getName().equals("quickjs-console"))
+                .count();
+    }
+}
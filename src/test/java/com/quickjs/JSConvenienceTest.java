@@ -45,6 +45,100 @@ public class JSConvenienceTest {
         }
     }
 
+    @Test
+    public void testIterableProtocol() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue map = context.eval("new Map([['a', 1], ['b', 2]])")) {
+                List<String> entries = new ArrayList<>();
+                for (JSValue entry : map) {
+                    try (entry) {
+                        entries.add(entry.toJSON());
+                    }
+                }
+                assertEquals(List.of("[\"a\",1]", "[\"b\",2]"), entries);
+            }
+
+            // Spans several native chunks
+            try (JSValue gen = context.eval("(function* () { for (let i = 0; i < 150; i++) yield i; })()")) {
+                int sum = 0;
+                int count = 0;
+                for (JSValue val : gen) {
+                    try (val) {
+                        sum += val.asInteger();
+                        count++;
+                    }
+                }
+                assertEquals(150, count);
+                assertEquals(149 * 150 / 2, sum);
+            }
+
+            // Array-likes without Symbol.iterator still iterate by index
+            try (JSValue arrayLike = context.eval("({ length: 2, 0: 'x', 1: 'y' })")) {
+                List<String> values = new ArrayList<>();
+                for (JSValue val : arrayLike) {
+                    try (val) {
+                        values.add(val.asString());
+                    }
+                }
+                assertEquals(List.of("x", "y"), values);
+            }
+
+            // The well-known symbol is used even after the global is replaced
+            context.eval("var realIterator = Symbol.iterator; Symbol = { iterator: 'fake' }").close();
+            try (JSValue set = context.eval("({ fake() { throw new Error('fake'); },"
+                    + " [realIterator]: function* () { yield 'real'; } })")) {
+                List<String> values = new ArrayList<>();
+                for (JSValue val : set) {
+                    try (val) {
+                        values.add(val.asString());
+                    }
+                }
+                assertEquals(List.of("real"), values);
+            }
+        }
+    }
+
+    @Test
+    public void testIteratorCloseCallsReturn() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue gen = context.eval("(function* () {"
+                    + " try { for (let i = 0; ; i++) yield i; } finally { globalThis.cleaned = true; } })()")) {
+                try (JSIterator it = gen.iterator()) {
+                    try (JSValue first = it.next()) {
+                        assertEquals(0, first.asInteger());
+                    }
+                }
+            }
+            try (JSValue cleaned = context.eval("globalThis.cleaned")) {
+                assertTrue(cleaned.asBoolean());
+            }
+
+            // A throwing next() ends the iteration; closing afterwards is a no-op
+            try (JSValue gen = context.eval("(function* () { yield 1; throw new Error('boom'); })()")) {
+                JSIterator it = gen.iterator();
+                assertThrows(QuickJSException.class, it::hasNext);
+                assertFalse(it.hasNext());
+                it.close();
+            }
+        }
+    }
+
+    @Test
+    public void testEntries() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue obj = context.eval("({ b: 1, a: 'two', [Symbol('s')]: 3 })")) {
+                java.util.Map<String, JSValue> entries = obj.entries();
+                assertEquals(List.of("b", "a"), new ArrayList<>(entries.keySet()));
+                assertEquals(1, entries.get("b").asInteger());
+                assertEquals("two", entries.get("a").asString());
+                entries.values().forEach(JSValue::close);
+            }
+        }
+    }
+
     @Test
     public void testHas() {
         try (JSRuntime runtime = QuickJS.createRuntime();
@@ -55,4 +55,27 @@ public class JSExceptionTest {
             assertTrue(msg.contains("at bar"), "Should contain stack trace 'at bar'");
         }
     }
+
+    @Test
+    public void testMessageIsFormattedLazily() throws Exception {
+        QuickJSException e;
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            e = assertThrows(JSTypeError.class, () -> context.eval("null.x"));
+
+            // Off the runtime thread the JS error cannot be read yet
+            String[] offThread = new String[1];
+            Thread reader = new Thread(() -> offThread[0] = e.getMessage());
+            reader.start();
+            reader.join();
+            assertTrue(offThread[0].contains("runtime thread"));
+
+            QuickJSException pending = assertThrows(JSRangeError.class,
+                    () -> context.eval("throw new RangeError('still pending')"));
+            // Closing the context formats exceptions that were never read
+            context.close();
+            assertTrue(pending.getMessage().contains("still pending"));
+        }
+        assertTrue(e.getMessage().contains("TypeError"));
+    }
 }
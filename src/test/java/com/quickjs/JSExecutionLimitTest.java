@@ -0,0 +1,71 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+import java.time.Duration;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSExecutionLimitTest {
+
+    @Test
+    public void testEvalTimeout() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            long start = System.currentTimeMillis();
+            JSTimeoutException e = assertThrows(JSTimeoutException.class, () -> {
+                context.eval("while(true) {}", JSExecutionLimit.timeout(Duration.ofMillis(100)));
+            });
+            assertTrue(e.getMessage().contains("deadline"));
+            assertTrue(System.currentTimeMillis() - start < 2000, "Should have been stopped quickly");
+
+            // The limit only applies to that eval
+            assertEquals(42, context.eval("40 + 2").asInteger());
+        }
+    }
+
+    @Test
+    public void testInterruptCheckBudget() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            JSTimeoutException e = assertThrows(JSTimeoutException.class, () -> {
+                context.eval("while(true) {}", JSExecutionLimit.interruptChecks(5));
+            });
+            assertTrue(e.getMessage().contains("budget"));
+
+            try (JSValue result = context.eval("1 + 2", JSExecutionLimit.interruptChecks(5))) {
+                assertEquals(3, result.asInteger());
+            }
+        }
+    }
+
+    @Test
+    public void testCallTimeout() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue spin = context.eval("(function() { for (;;) {} })")) {
+                assertThrows(JSTimeoutException.class, () -> {
+                    spin.call(null, JSExecutionLimit.timeout(Duration.ofMillis(50)));
+                });
+            }
+        }
+    }
+
+    @Test
+    public void testScriptCannotCatchTimeout() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            assertThrows(JSTimeoutException.class, () -> {
+                context.eval("for (;;) { try { while(true) {} } catch (e) {} }",
+                        JSExecutionLimit.interruptChecks(10));
+            });
+        }
+    }
+
+    @Test
+    public void testExpiredDeadline() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            JSExecutionLimit limit = JSExecutionLimit.deadline(System.nanoTime() - 1);
+            assertThrows(JSTimeoutException.class, () -> context.eval("1", limit));
+        }
+    }
+}
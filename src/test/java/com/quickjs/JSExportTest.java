@@ -0,0 +1,163 @@
+package com.quickjs;
+
+import com.quickjs.processor.JSExportProcessor;
+import org.junit.jupiter.api.Test;
+
+import javax.tools.Diagnostic;
+import javax.tools.DiagnosticCollector;
+import javax.tools.JavaCompiler;
+import javax.tools.JavaFileObject;
+import javax.tools.SimpleJavaFileObject;
+import javax.tools.ToolProvider;
+import java.net.URI;
+import java.util.List;
+import java.util.stream.Collectors;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSExportTest {
+
+    @JSExport("Calculator")
+    public static class Calculator {
+        private double total;
+
+        @JSExport
+        public double add(double value) {
+            total += value;
+            return total;
+        }
+
+        @JSExport("label")
+        public String describe(String prefix, int precision) {
+            return prefix + String.format("%." + precision + "f", total);
+        }
+
+        @JSExport(getter = true)
+        public double getTotal() {
+            return total;
+        }
+
+        @JSExport
+        public void fail() {
+            throw new IllegalStateException("calculator broke");
+        }
+
+        public void hidden() {
+        }
+    }
+
+    @JSExport("Counter")
+    public static class Counter {
+        private int count;
+
+        @JSExport
+        public int increment() {
+            return ++count;
+        }
+    }
+
+    @Test
+    public void testMethodsAndGetters() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            Calculator calc = new Calculator();
+            try (JSValue jsCalc = context.exportObject(calc)) {
+                context.setGlobal("calc", jsCalc);
+            }
+
+            assertEquals(5, context.eval("calc.add(2); calc.add(3)").asInteger());
+            assertEquals(5.0, calc.getTotal());
+            assertEquals(5, context.eval("calc.total").asInteger());
+            assertEquals("sum=5.00", context.eval("calc.label('sum=', 2)").asString());
+            assertTrue(context.eval("typeof calc.hidden === 'undefined'").asBoolean());
+        }
+    }
+
+    @Test
+    public void testJavaExceptionBecomesJSError() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue jsCalc = context.exportObject(new Calculator())) {
+                context.setGlobal("calc", jsCalc);
+            }
+            String msg = context.eval("try { calc.fail(); 'no error' } catch (e) { e.message }").asString();
+            assertTrue(msg.contains("calculator broke"), msg);
+        }
+    }
+
+    @Test
+    public void testMethodRequiresExportedReceiver() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue jsCalc = context.exportObject(new Calculator())) {
+                context.setGlobal("calc", jsCalc);
+            }
+            assertThrows(JSTypeError.class, () -> context.eval("calc.add.call({}, 1)"));
+        }
+    }
+
+    @Test
+    public void testMethodRejectsReceiverOfOtherExportedClass() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            Counter counter = new Counter();
+            try (JSValue jsCalc = context.exportObject(new Calculator());
+                    JSValue jsCounter = context.exportObject(counter)) {
+                context.setGlobal("calc", jsCalc);
+                context.setGlobal("counter", jsCounter);
+            }
+            assertThrows(JSTypeError.class, () -> context.eval("calc.add.call(counter, 1)"));
+            assertThrows(JSTypeError.class, () -> context.eval("calc.label.call(counter, 'x', 2)"));
+            assertThrows(JSTypeError.class, () -> context.eval("counter.increment.call(calc)"));
+            assertEquals(1, context.eval("counter.increment()").asInteger());
+            assertEquals(1, counter.count);
+        }
+    }
+
+    @Test
+    public void testUnannotatedClassRejected() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            assertThrows(IllegalArgumentException.class, () -> context.exportObject(new Object()));
+        }
+    }
+
+    @Test
+    public void testProcessorRejectsDuplicateNames() {
+        List<String> errors = processorErrors("Dup",
+                "@com.quickjs.JSExport public class Dup {"
+                        + " @com.quickjs.JSExport public int add(int a) { return a; }"
+                        + " @com.quickjs.JSExport public int add(int a, int b) { return a + b; }"
+                        + " @com.quickjs.JSExport(\"sum\") public int total() { return 0; }"
+                        + " @com.quickjs.JSExport(\"sum\") public int count() { return 0; } }");
+        assertEquals(2, errors.size(), errors.toString());
+        assertTrue(errors.get(0).contains("Duplicate @JSExport name \"add\""), errors.get(0));
+        assertTrue(errors.get(1).contains("Duplicate @JSExport name \"sum\""), errors.get(1));
+    }
+
+    @Test
+    public void testProcessorRejectsNonClassTypes() {
+        assertEquals(1, processorErrors("Iface", "@com.quickjs.JSExport public interface Iface {}").size());
+        assertEquals(1, processorErrors("Color", "@com.quickjs.JSExport public enum Color { RED }").size());
+    }
+
+    private static List<String> processorErrors(String className, String source) {
+        JavaCompiler compiler = ToolProvider.getSystemJavaCompiler();
+        JavaFileObject file = new SimpleJavaFileObject(URI.create("string:///" + className + ".java"),
+                JavaFileObject.Kind.SOURCE) {
+            @Override
+            public CharSequence getCharContent(boolean ignoreEncodingErrors) {
+                return source;
+            }
+        };
+        DiagnosticCollector<JavaFileObject> diagnostics = new DiagnosticCollector<>();
+        JavaCompiler.CompilationTask task = compiler.getTask(null, null, diagnostics,
+                List.of("-proc:only", "-classpath", System.getProperty("java.class.path")), null, List.of(file));
+        task.setProcessors(List.of(new JSExportProcessor()));
+        task.call();
+        return diagnostics.getDiagnostics().stream()
+                .filter(d -> d.getKind() == Diagnostic.Kind.ERROR)
+                .map(d -> d.getMessage(null))
+                .collect(Collectors.toList());
+    }
+}
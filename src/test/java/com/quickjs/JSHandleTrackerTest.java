@@ -0,0 +1,79 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSHandleTrackerTest {
+
+    @Test
+    public void testLiveHandlesGroupedBySite() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableHandleTracking(1, false);
+            assertEquals(0, runtime.liveHandleCount());
+
+            List<JSValue> leaked = new ArrayList<>();
+            for (int i = 0; i < 3; i++) {
+                leaked.add(leak(context, i));
+            }
+            context.createString("closed").close();
+
+            assertEquals(3, runtime.liveHandleCount());
+            List<JSHandleSite> sites = runtime.liveHandles();
+            assertEquals(1, sites.size());
+            JSHandleSite site = sites.get(0);
+            assertEquals(3, site.getLiveCount());
+            StackTraceElement top = site.getStackTrace()[0];
+            assertEquals(JSHandleTrackerTest.class.getName(), top.getClassName());
+            assertEquals("leak", top.getMethodName());
+
+            for (JSValue value : leaked) {
+                value.close();
+            }
+            assertEquals(0, runtime.liveHandleCount());
+            assertTrue(runtime.liveHandles().isEmpty());
+        }
+    }
+
+    @Test
+    public void testSampling() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableHandleTracking(4, false);
+            List<JSValue> leaked = new ArrayList<>();
+            for (int i = 0; i < 8; i++) {
+                leaked.add(leak(context, i));
+            }
+            assertEquals(8, runtime.liveHandleCount());
+            assertEquals(2, runtime.liveHandles().get(0).getLiveCount());
+            for (JSValue value : leaked) {
+                value.close();
+            }
+            assertEquals(0, runtime.liveHandleCount());
+        }
+    }
+
+    @Test
+    public void testDisabled() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            assertThrows(IllegalStateException.class, runtime::liveHandles);
+            assertThrows(IllegalArgumentException.class, () -> runtime.enableHandleTracking(0, false));
+
+            runtime.enableHandleTracking();
+            JSValue value = leak(context, 1);
+            runtime.disableHandleTracking();
+            assertThrows(IllegalStateException.class, runtime::liveHandleCount);
+            // Freeing a handle tracked before tracking was disabled is harmless
+            value.close();
+        }
+    }
+
+    private static JSValue leak(JSContext context, int i) {
+        return context.createInteger(i);
+    }
+}
@@ -0,0 +1,87 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSMetricsTest {
+
+    @Test
+    public void testHistogramsCountOperations() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableMetrics();
+            try (JSValue host = context.createFunction((ctx, thisObj, args) -> null, "host", 0)) {
+                context.setGlobal("host", host);
+            }
+            try (JSValue fn = context.eval("(function work() { host(); host(); })")) {
+                fn.call(null).close();
+            }
+            runtime.runGC();
+            runtime.runEventLoop();
+
+            assertEquals(1, runtime.getLatencyHistogram(JSOperation.EVAL).getCount());
+            assertEquals(1, runtime.getLatencyHistogram(JSOperation.CALL).getCount());
+            assertEquals(2, runtime.getLatencyHistogram(JSOperation.HOST_CALLBACK).getCount());
+            assertEquals(1, runtime.getLatencyHistogram(JSOperation.GC).getCount());
+            assertEquals(1, runtime.getLatencyHistogram(JSOperation.EVENT_LOOP).getCount());
+
+            JSLatencyHistogram eval = runtime.getLatencyHistogram(JSOperation.EVAL);
+            assertTrue(eval.getValueAtPercentile(99) <= eval.getMax());
+
+            runtime.disableMetrics();
+            assertThrows(IllegalStateException.class, () -> runtime.getLatencyHistogram(JSOperation.EVAL));
+        }
+    }
+
+    @Test
+    public void testListenerReceivesTags() {
+        List<String> events = new ArrayList<>();
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableMetrics((op, file, function, nanos) -> events.add(op + " " + file + " " + function));
+            try (JSValue host = context.createFunction((ctx, thisObj, args) -> null, "host", 0)) {
+                context.setGlobal("host", host);
+            }
+            context.eval("function work() { host(); }", "app.js", JSContext.EVAL_TYPE_GLOBAL).close();
+            try (JSValue global = context.getGlobalObject();
+                    JSValue work = global.getProperty("work")) {
+                work.call(null).close();
+            }
+        }
+        assertEquals(List.of("EVAL app.js null", "HOST_CALLBACK app.js host", "CALL null work"), events);
+    }
+
+    @Test
+    public void testCallTagRunsNoScript() {
+        List<String> events = new ArrayList<>();
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.enableMetrics((op, file, function, nanos) -> events.add(op + " " + function));
+            try (JSValue getter = context.eval("var reads = 0; var f = function () { throw new Error('own'); };"
+                    + " Object.defineProperty(f, 'name', { get() { reads++; throw new Error('getter'); } }); f");
+                    JSValue proxy = context.eval("new Proxy(function inner() { return 1; },"
+                            + " { getOwnPropertyDescriptor() { reads++; throw new Error('trap'); } })")) {
+                QuickJSException e = assertThrows(QuickJSException.class, () -> getter.call(null));
+                assertTrue(e.getMessage().contains("own"), e.getMessage());
+                proxy.call(null).close();
+            }
+            try (JSValue reads = context.eval("reads")) {
+                assertEquals(0, reads.asInteger());
+            }
+        }
+        assertEquals(List.of("EVAL null", "EVAL null", "CALL null", "CALL null", "EVAL null"), events);
+    }
+
+    @Test
+    public void testHistogramBuckets() {
+        for (long v : new long[] { 0, 7, 8, 15, 16, 1000, 123456789, Long.MAX_VALUE }) {
+            int index = JSLatencyHistogram.index(v);
+            assertTrue(JSLatencyHistogram.upperBound(index) >= v);
+            assertTrue(index == 0 || JSLatencyHistogram.upperBound(index - 1) < v);
+        }
+    }
+}
@@ -1,6 +1,9 @@
 package com.quickjs;
 
 import org.junit.jupiter.api.Test;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
 import static org.junit.jupiter.api.Assertions.*;
 
 public class JSModuleTest {
@@ -56,4 +59,31 @@ public class JSModuleTest {
             }
         }
     }
+
+    @Test
+    public void testHostModule() {
+        try (JSRuntime runtime = QuickJS.createRuntime()) {
+            Map<String, JSFunction> exports = new LinkedHashMap<>();
+            exports.put("add", (ctx, thisObj, args) -> ctx.createInteger(args[0].asInteger() + args[1].asInteger()));
+            exports.put("name", (ctx, thisObj, args) -> ctx.createString("db"));
+            runtime.registerHostModule("host:db", exports);
+            runtime.setModuleLoader(moduleName -> "local".equals(moduleName) ? "export const x = 1;" : null);
+
+            try (JSContext context = runtime.createContext()) {
+                context.eval("import { add, name } from 'host:db'; import { x } from 'local';"
+                        + " globalThis.result = name() + add(2, 3) + x;", "main.js", JSContext.EVAL_TYPE_MODULE)
+                        .close();
+                runtime.runEventLoop();
+                try (JSValue global = context.getGlobalObject();
+                        JSValue result = global.getProperty("result")) {
+                    assertEquals("db51", result.asString());
+                }
+                assertThrows(QuickJSException.class,
+                        () -> context.eval("import { missing } from 'host:db';", "bad.js",
+                                JSContext.EVAL_TYPE_MODULE));
+            }
+
+            assertThrows(IllegalStateException.class, () -> runtime.registerHostModule("host:db", exports));
+        }
+    }
 }
@@ -0,0 +1,56 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSProfilerTest {
+
+    @Test
+    public void testSamplesHotFunction() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            runtime.startProfiling(100);
+            context.eval("function hot() { var x = 0; for (var i = 0; i < 1e5; i++) x += i; return x; }"
+                    + "function outer() { var start = Date.now(); while (Date.now() - start < 200) hot(); }"
+                    + "outer();", "prof.js", JSContext.EVAL_TYPE_GLOBAL);
+            JSProfile profile = runtime.stopProfiling();
+
+            assertTrue(profile.getSampleCount() > 0, "Should have collected samples");
+            boolean sawHot = profile.getStacks().keySet().stream()
+                    .anyMatch(stack -> stack.contains("outer (prof.js:1);hot (prof.js:1)"));
+            assertTrue(sawHot, "Expected outer;hot stack, got: " + profile.toCollapsedStacks());
+        }
+    }
+
+    @Test
+    public void testSamplesIgnoreScriptErrorHooks() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            context.eval("var calls = 0; var E = Error;"
+                    + " E.stackTraceLimit = 1; E.prepareStackTrace = () => { calls++; return 'x'; };"
+                    + " globalThis.Error = function () { calls++; };");
+            runtime.startProfiling(100);
+            context.eval("function hot() { var x = 0; for (var i = 0; i < 1e5; i++) x += i; return x; }"
+                    + "function outer() { var start = Date.now(); while (Date.now() - start < 200) hot(); }"
+                    + "outer();", "prof.js", JSContext.EVAL_TYPE_GLOBAL);
+            JSProfile profile = runtime.stopProfiling();
+
+            boolean sawHot = profile.getStacks().keySet().stream()
+                    .anyMatch(stack -> stack.contains("outer (prof.js:1);hot (prof.js:1)"));
+            assertTrue(sawHot, "Expected outer;hot stack, got: " + profile.toCollapsedStacks());
+            try (JSValue result = context.eval("calls + ':' + E.stackTraceLimit")) {
+                assertEquals("0:1", result.asString());
+            }
+        }
+    }
+
+    @Test
+    public void testStopWithoutSamples() {
+        try (JSRuntime runtime = QuickJS.createRuntime()) {
+            runtime.startProfiling();
+            JSProfile profile = runtime.stopProfiling();
+            assertEquals(0, profile.getSampleCount());
+            assertEquals("", profile.toCollapsedStacks());
+        }
+    }
+}
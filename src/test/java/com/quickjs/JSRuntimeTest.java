@@ -1,6 +1,7 @@
 package com.quickjs;
 
 import org.junit.jupiter.api.Test;
+import java.lang.ref.WeakReference;
 import java.util.concurrent.atomic.AtomicBoolean;
 import static org.junit.jupiter.api.Assertions.*;
 
@@ -45,4 +46,54 @@ public class JSRuntimeTest {
             assertTrue(threadFailed.get(), "Should fail when accessing JSRuntime from another thread");
         }
     }
+
+    @Test
+    public void testCollectedValuesAreReleasedOnOwnerThread() throws InterruptedException {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            for (int i = 0; i < 1000; i++) {
+                context.eval("({ index: " + i + " })");
+            }
+            // Leaked handles are only queued by the Cleaner thread
+            long deadline = System.nanoTime() + 10_000_000_000L;
+            while (runtime.releaseQueue().isEmpty() && System.nanoTime() < deadline) {
+                System.gc();
+                Thread.sleep(10);
+            }
+            assertFalse(runtime.releaseQueue().isEmpty(), "Cleaner should have queued collected values");
+
+            runtime.runEventLoop();
+            assertTrue(runtime.releaseQueue().isEmpty());
+            try (JSValue result = context.eval("1 + 1")) {
+                assertEquals(2, result.asInteger());
+            }
+        }
+    }
+
+    @Test
+    public void testUnreachableRuntimeFreesItsHandles() throws InterruptedException {
+        JSReleaseQueue queue = leakRuntime();
+        long deadline = System.nanoTime() + 10_000_000_000L;
+        while (!queue.isFreed() && System.nanoTime() < deadline) {
+            System.gc();
+            Thread.sleep(10);
+        }
+        assertTrue(queue.isFreed(), "Runtime cleaner should have freed the leaked handles");
+        // Handles collected afterwards are already gone with the runtime
+        System.gc();
+        Thread.sleep(100);
+        assertTrue(queue.isEmpty());
+    }
+
+    // Contexts and values are neither closed nor drained before the runtime is
+    private static JSReleaseQueue leakRuntime() {
+        JSRuntime runtime = QuickJS.createRuntime();
+        JSContext context = runtime.createContext();
+        for (int i = 0; i < 100; i++) {
+            context.eval("({ index: " + i + " })");
+        }
+        runtime.createContext().eval("[1, 2, 3]");
+        runtime.close();
+        return runtime.releaseQueue();
+    }
 }
@@ -1,6 +1,9 @@
 package com.quickjs;
 
 import org.junit.jupiter.api.Test;
+
+import java.util.EnumSet;
+
 import static org.junit.jupiter.api.Assertions.*;
 
 public class JSSandboxTest {
@@ -80,4 +83,52 @@ public class JSSandboxTest {
             }
         }
     }
+
+    @Test
+    public void testSelectedIntrinsics() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext(EnumSet.of(JSIntrinsic.JSON))) {
+            assertEquals(3, context.eval("JSON.parse('[1, 2]').length + Math.min(1, 2)").asInteger());
+            assertEquals("undefined", context.eval("typeof RegExp").asString());
+            assertEquals("undefined", context.eval("typeof Promise").asString());
+            assertEquals("undefined", context.eval("typeof Uint8Array").asString());
+            assertEquals("undefined", context.eval("typeof Date").asString());
+        }
+    }
+
+    @Test
+    public void testEvalIntrinsicOnlyAffectsScripts() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext(EnumSet.of(JSIntrinsic.PROMISE))) {
+            assertEquals("undefined function true", context.eval(
+                    "typeof eval + ' ' + typeof Function + ' ' + ((() => {}) instanceof Function)").asString());
+            assertEquals("EvalError", context.eval(
+                    "try { Function('return 1'); 'compiled' } catch (e) { e.name }").asString());
+            assertEquals("EvalError", context.eval(
+                    "try { Object.getPrototypeOf(function* () {}).constructor('yield 1'); 'compiled' }"
+                            + " catch (e) { e.name }").asString());
+            assertEquals("EvalError", context.eval(
+                    "try { (function () {}).constructor('return 1'); 'compiled' } catch (e) { e.name }").asString());
+            assertEquals("EvalError", context.eval(
+                    "try { Object.getPrototypeOf(async function () {}).constructor('return 1'); 'compiled' }"
+                            + " catch (e) { e.name }").asString());
+            // Java's eval and modules still compile
+            context.eval("globalThis.loaded = 7", "mod.js", JSContext.EVAL_TYPE_MODULE).close();
+            runtime.runEventLoop();
+            assertEquals(7, context.eval("loaded").asInteger());
+        }
+    }
+
+    @Test
+    public void testBuilderIntrinsicsAreTheDefault() {
+        try (JSRuntime runtime = QuickJS.builder().withIntrinsics(EnumSet.of(JSIntrinsic.MAP_SET)).build()) {
+            try (JSContext context = runtime.createContext()) {
+                assertEquals("function", context.eval("typeof Map").asString());
+                assertEquals("undefined", context.eval("typeof JSON").asString());
+            }
+            try (JSContext context = runtime.createContext(EnumSet.allOf(JSIntrinsic.class))) {
+                assertEquals("object", context.eval("typeof JSON").asString());
+            }
+        }
+    }
 }
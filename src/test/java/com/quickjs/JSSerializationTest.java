@@ -0,0 +1,76 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.nio.ByteBuffer;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSSerializationTest {
+
+    @Test
+    public void testRoundTripAcrossRuntimes() {
+        byte[] data;
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue value = context.eval(
+                        "({ n: 1.5, big: 12345678901234567890n, when: new Date(0),"
+                                + " nested: { k: [1, 2] }, bytes: new Uint8Array([7, 8]) })")) {
+            data = value.serialize();
+        }
+
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue copy = context.deserialize(data)) {
+                context.setGlobal("copy", copy);
+            }
+            assertTrue(context.eval("copy.n === 1.5 && copy.big === 12345678901234567890n").asBoolean());
+            assertTrue(context.eval("copy.when instanceof Date && copy.when.getTime() === 0").asBoolean());
+            assertEquals(2, context.eval("copy.nested.k[1]").asInteger());
+            assertEquals(8, context.eval("copy.bytes instanceof Uint8Array && copy.bytes[1]").asInteger());
+        }
+    }
+
+    @Test
+    public void testSharedReferencesAndCycles() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            byte[] data;
+            try (JSValue value = context.eval(
+                    "const shared = { x: 1 }; const o = { a: shared, b: shared }; o.self = o; o")) {
+                data = value.serialize();
+            }
+            try (JSValue copy = context.deserialize(data)) {
+                context.setGlobal("copy", copy);
+            }
+            assertTrue(context.eval("copy.a === copy.b && copy.self === copy").asBoolean());
+        }
+    }
+
+    @Test
+    public void testDirectByteBuffer() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            byte[] data;
+            try (JSValue value = context.eval("[1, 'two', [3]]")) {
+                data = value.serialize();
+            }
+            ByteBuffer buffer = ByteBuffer.allocateDirect(data.length + 4);
+            buffer.putInt(0xCAFE).put(data).flip().position(4);
+
+            try (JSValue copy = context.deserialize(buffer)) {
+                assertEquals("[1,\"two\",[3]]", copy.toJSON());
+            }
+            assertEquals(4, buffer.position());
+        }
+    }
+
+    @Test
+    public void testFunctionsAreRejected() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue value = context.eval("({ f() {} })")) {
+            assertThrows(QuickJSException.class, value::serialize);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSShareFrozenTest {
+
+    @Test
+    public void testSharedAcrossContexts() {
+        try (JSRuntime runtime = QuickJS.createRuntime()) {
+            JSContext existing = runtime.createContext();
+            try (JSContext loader = runtime.createContext();
+                    JSValue tariffs = loader.parseJSON("{\"zones\": [{\"id\": 1, \"rate\": 0.5}], \"currency\": \"EUR\"}")) {
+                runtime.shareFrozen("tariffs", tariffs);
+            }
+            // The loader is closed, but the shared graph lives on
+            try (JSContext later = runtime.createContext()) {
+                for (JSContext context : new JSContext[] { existing, later }) {
+                    try (JSValue rate = context.eval("tariffs.zones[0].rate")) {
+                        assertEquals(0.5, rate.asDouble());
+                    }
+                    try (JSValue frozen = context.eval(
+                            "Object.isFrozen(tariffs) && Object.isFrozen(tariffs.zones) && Object.isFrozen(tariffs.zones[0])")) {
+                        assertTrue(frozen.asBoolean());
+                    }
+                }
+                existing.eval("tariffs.zones[0].rate = 2; tariffs.extra = 1; tariffs = null").close();
+                try (JSValue result = later.eval("tariffs.zones[0].rate + ':' + ('extra' in tariffs)")) {
+                    assertEquals("0.5:false", result.asString());
+                }
+                assertThrows(JSTypeError.class, () -> later.eval("'use strict'; tariffs.zones[0].rate = 2"));
+                try (JSValue same = later.eval("globalThis.tariffs")) {
+                    existing.setGlobal("fromLater", same);
+                }
+                try (JSValue identical = existing.eval("fromLater === tariffs")) {
+                    assertTrue(identical.asBoolean());
+                }
+            }
+            existing.close();
+        }
+    }
+
+    @Test
+    public void testPrototypesCannotBeTamperedWith() {
+        try (JSRuntime runtime = QuickJS.createRuntime()) {
+            try (JSContext loader = runtime.createContext();
+                    JSValue tariffs = loader.parseJSON("{\"zones\": [{\"id\": 1}, {\"id\": 2}]}")) {
+                runtime.shareFrozen("tariffs", tariffs);
+            }
+            try (JSContext attacker = runtime.createContext();
+                    JSContext victim = runtime.createContext()) {
+                attacker.eval("Object.getPrototypeOf(tariffs.zones).map = () => 'evil';"
+                        + " Object.getPrototypeOf(tariffs).toString = () => 'evil';"
+                        + " try { Object.setPrototypeOf(Object.getPrototypeOf(tariffs.zones), null) } catch (e) {}").close();
+                assertThrows(JSTypeError.class,
+                        () -> attacker.eval("'use strict'; Object.getPrototypeOf(tariffs.zones).map = () => 'evil'"));
+                try (JSValue ids = victim.eval("tariffs.zones.map(z => z.id).join(',') + ' ' + String(tariffs)")) {
+                    assertEquals("1,2 [object Object]", ids.asString());
+                }
+            }
+        }
+    }
+
+    @Test
+    public void testSourceContextIsLeftWritable() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue config = context.eval("var config = { limits: [1, 2] }; config")) {
+                runtime.shareFrozen("shared", config);
+            }
+            try (JSValue result = context.eval("'use strict';"
+                    + " Array.prototype.last = function () { return this[this.length - 1]; };"
+                    + " const o = {}; o.toString = () => 'mine'; config.limits.push(3);"
+                    + " [String(o), config.limits.last(), Object.isFrozen(config),"
+                    + " Object.isFrozen(shared.limits), typeof shared.limits.last].join()")) {
+                assertEquals("mine,3,false,true,undefined", result.asString());
+            }
+            try (JSValue fn = context.eval("({ f() {} })")) {
+                assertThrows(QuickJSException.class, () -> runtime.shareFrozen("fn", fn));
+            }
+        }
+    }
+
+    @Test
+    public void testCyclesAndErrors() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext()) {
+            try (JSValue cyclic = context.eval("const a = { name: 'a' }; a.self = a; a")) {
+                runtime.shareFrozen("cyclic", cyclic);
+            }
+            try (JSValue name = context.eval("cyclic.self.self.name")) {
+                assertEquals("a", name.asString());
+            }
+
+            try (JSValue other = context.eval("({})")) {
+                assertThrows(IllegalStateException.class, () -> runtime.shareFrozen("cyclic", other));
+            }
+            try (JSValue typed = context.eval("new Uint8Array(4)")) {
+                assertThrows(QuickJSException.class, () -> runtime.shareFrozen("bytes", typed));
+            }
+            try (JSValue missing = context.eval("typeof bytes")) {
+                assertEquals("undefined", missing.asString());
+            }
+
+            try (JSContext other = runtime.createContext();
+                    JSValue data = context.eval("({ x: 1 })")) {
+                other.eval("var taken = 1").close();
+                assertThrows(IllegalArgumentException.class, () -> runtime.shareFrozen("taken", data));
+                assertThrows(IllegalArgumentException.class, () -> runtime.shareFrozen("undefined", data));
+                // Nothing was registered, so contexts are still created normally
+                runtime.createContext().close();
+                runtime.shareFrozen("data", data);
+                try (JSValue x = other.eval("data.x")) {
+                    assertEquals(1, x.asInteger());
+                }
+            }
+        }
+    }
+}
@@ -65,4 +65,41 @@ public class JSValueTest {
             }
         }
     }
+
+    @Test
+    public void testTypeChecksAgreeWithTags() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSValue integer = context.eval("-7");
+                JSValue number = context.eval("2.5");
+                JSValue bool = context.eval("true");
+                JSValue string = context.eval("'s'");
+                JSValue array = context.eval("[1]");
+                JSValue function = context.eval("(function() {})");
+                JSValue error = context.eval("new TypeError('x')");
+                JSValue nul = context.eval("null");
+                JSValue undef = context.eval("undefined")) {
+            // On JDK 22+ (and only there) the multi-release jar's class binds
+            // these as FFM downcalls instead of JNI
+            boolean ffm = Runtime.version().feature() >= 22;
+            boolean boundDowncalls = java.util.Arrays.stream(JSDowncalls.class.getDeclaredFields())
+                    .anyMatch(f -> f.getType() == java.lang.invoke.MethodHandle.class);
+            assertEquals(ffm, boundDowncalls);
+            assertEquals(ffm, JSDowncalls.ENABLED);
+            assertTrue(integer.isInteger() && integer.isNumber() && !integer.isString());
+            assertEquals(-7, integer.asInteger());
+            assertEquals(-7.0, integer.asDouble());
+            assertTrue(number.isNumber() && !number.isInteger());
+            assertEquals(2.5, number.asDouble());
+            assertEquals(2, number.asInteger());
+            assertTrue(bool.isBoolean() && bool.asBoolean());
+            assertTrue(string.isString() && !string.isObject());
+            assertTrue(array.isArray() && array.isObject() && !array.isFunction());
+            assertTrue(function.isFunction() && !function.isArray());
+            assertTrue(error.isError() && !array.isError());
+            assertTrue(nul.isNull() && !nul.isUndefined());
+            assertTrue(undef.isUndefined() && !undef.isNull());
+            assertEquals(0, integer.getTypeTag());
+        }
+    }
 }
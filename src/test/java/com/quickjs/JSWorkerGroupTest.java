@@ -0,0 +1,59 @@
+package com.quickjs;
+
+import org.junit.jupiter.api.Test;
+
+import java.time.Duration;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+public class JSWorkerGroupTest {
+
+    @Test
+    public void testWorkersShareMemory() throws InterruptedException {
+        String script = "onmessage = (sab, from) => {"
+                + "  const counts = new Int32Array(sab);"
+                + "  for (let i = 0; i < 1000; i++) Atomics.add(counts, 0, 1);"
+                + "  Atomics.store(counts, workerId + 1, workerId + 1);"
+                + "  postMessage(from, workerId);"
+                + "};";
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSWorkerGroup group = JSWorkerGroup.start(3, script)) {
+            try (JSValue sab = context.eval("globalThis.sab = new SharedArrayBuffer(16); sab")) {
+                for (int i = 0; i < group.size(); i++) {
+                    group.postMessage(i, sab);
+                }
+            }
+            for (int i = 0; i < group.size(); i++) {
+                try (JSValue reply = group.receive(context, Duration.ofSeconds(10))) {
+                    assertNotNull(reply);
+                }
+            }
+            assertEquals("3000,1,2,3", context.eval("Array.from(new Int32Array(sab)).join()").asString());
+        }
+    }
+
+    @Test
+    public void testWorkersMessageEachOther() throws InterruptedException {
+        String script = "if (workerId === 0) postMessage(1, { hops: 1 });"
+                + "onmessage = (msg) => postMessage(-1, { hops: msg.hops + 1, at: workerId });";
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSWorkerGroup group = JSWorkerGroup.start(2, script)) {
+            try (JSValue reply = group.receive(context, Duration.ofSeconds(10))) {
+                assertEquals("{\"hops\":2,\"at\":1}", reply.toJSON());
+            }
+        }
+    }
+
+    @Test
+    public void testWorkerErrorIsReported() {
+        try (JSRuntime runtime = QuickJS.createRuntime();
+                JSContext context = runtime.createContext();
+                JSWorkerGroup group = JSWorkerGroup.start(1, "throw new Error('boom')")) {
+            QuickJSException e = assertThrows(QuickJSException.class,
+                    () -> group.receive(context, Duration.ofSeconds(10)));
+            assertTrue(e.getMessage().contains("boom"));
+        }
+    }
+}